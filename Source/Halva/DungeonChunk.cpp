@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "DungeonChunk.h"
+
+/**********************************************************************************************************
+*	DungeonChunk()
+*		Purpose:	Default constructor. Results in a 0x0 chunk.
+**********************************************************************************************************/
+DungeonChunk::DungeonChunk()
+{
+	m_chunkX = 0;
+	m_chunkY = 0;
+	m_originX = 0;
+	m_originY = 0;
+	m_width = 0;
+	m_height = 0;
+}
+/**********************************************************************************************************
+*	int GetChunkX()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int DungeonChunk::GetChunkX() const
+{
+	return m_chunkX;
+}
+/**********************************************************************************************************
+*	int GetChunkY()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int DungeonChunk::GetChunkY() const
+{
+	return m_chunkY;
+}
+/**********************************************************************************************************
+*	int GetOriginX()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int DungeonChunk::GetOriginX() const
+{
+	return m_originX;
+}
+/**********************************************************************************************************
+*	int GetOriginY()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int DungeonChunk::GetOriginY() const
+{
+	return m_originY;
+}
+/**********************************************************************************************************
+*	int GetWidth()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int DungeonChunk::GetWidth() const
+{
+	return m_width;
+}
+/**********************************************************************************************************
+*	int GetHeight()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int DungeonChunk::GetHeight() const
+{
+	return m_height;
+}
+/**********************************************************************************************************
+*	TileLayoutView GetTiles()
+*		Purpose:	Getter. Returns a view over the chunk's tiles. Tile (0, 0) of the view is the layout
+*					tile at the chunk's origin.
+**********************************************************************************************************/
+TileLayoutView DungeonChunk::GetTiles()
+{
+	return TileLayoutView(m_tiles.GetData(), m_width, m_height);
+}
+/**********************************************************************************************************
+*	void Reset(int ChunkX, int ChunkY, int OriginX, int OriginY, int Width, int Height)
+*		Purpose:	Resizes the chunk and moves it to a new place in the layout. The tile buffer is only
+*					reallocated if it has to grow.
+*
+*		Parameters:
+*			int ChunkX, int ChunkY
+*				Which chunk of the layout this is.
+*			int OriginX, int OriginY
+*				The layout position of the chunk's first tile.
+*			int Width, int Height
+*				The size of the chunk.
+*
+*		Changes:
+*			m_tiles - Resized and every tile made empty.
+**********************************************************************************************************/
+void DungeonChunk::Reset(int ChunkX, int ChunkY, int OriginX, int OriginY, int Width, int Height)
+{
+	m_chunkX = ChunkX;
+	m_chunkY = ChunkY;
+	m_originX = OriginX;
+	m_originY = OriginY;
+	m_width = Width > 0 ? Width : 0;
+	m_height = Height > 0 ? Height : 0;
+
+	m_tiles.Reset(m_width * m_height);
+	m_tiles.AddZeroed(m_width * m_height);
+}
+/**********************************************************************************************************
+*	bool ContainsTile(int X, int Y)
+*		Purpose:	Checks if a layout tile is in the chunk.
+*
+*		Return:		True if (X, Y) is in the chunk.
+**********************************************************************************************************/
+bool DungeonChunk::ContainsTile(int X, int Y) const
+{
+	return X >= m_originX && Y >= m_originY && X < m_originX + m_width && Y < m_originY + m_height;
+}
+/**********************************************************************************************************
+*	TileData GetTile(int X, int Y)
+*		Purpose:	Getter. Looks up a tile by its layout position.
+*
+*		Parameters:
+*			int X, int Y
+*				The layout position of the tile. Must be in the chunk.
+*
+*		Return:		The tile at (X, Y).
+**********************************************************************************************************/
+TileData DungeonChunk::GetTile(int X, int Y) const
+{
+	check(ContainsTile(X, Y));
+
+	return m_tiles[(Y - m_originY) * m_width + X - m_originX];
+}
+/**********************************************************************************************************
+*	SIZE_T GetAllocatedSize()
+*		Purpose:	Getter. The number of bytes allocated to hold the tiles.
+**********************************************************************************************************/
+SIZE_T DungeonChunk::GetAllocatedSize() const
+{
+	return m_tiles.GetAllocatedSize();
+}
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "TileStructure.h"
+/**********************************************************************************************************
+*	Class: DungeonChunk
+*
+*	Overview:
+*		The finished tiles of one square chunk of a chunked DungeonLayout. The chunk covers the tiles
+*		from its origin up to its width and height, which are the layout's chunk size except for chunks
+*		on the north and east edges of the layout. The tiles are stored row-major like a full layout.
+*
+*	Manager Functions:
+*
+*		DungeonChunk();
+*			Default constructor. Results in a 0x0 chunk.
+*
+*	Mutators:
+*
+*		ChunkX
+*			-Get
+*		ChunkY
+*			-Get
+*		OriginX
+*			-Get
+*		OriginY
+*			-Get
+*		Width
+*			-Get
+*		Height
+*			-Get
+*		Tiles
+*			-Get
+*
+*	Methods:
+*
+*		void Reset(int ChunkX, int ChunkY, int OriginX, int OriginY, int Width, int Height)
+*			Resizes the chunk and moves it to a new place in the layout. Every tile is made empty.
+*		bool ContainsTile(int X, int Y)
+*			Returns if the layout tile (X, Y) is in the chunk.
+*		TileData GetTile(int X, int Y)
+*			Returns the layout tile (X, Y), which must be in the chunk.
+*		SIZE_T GetAllocatedSize()
+*			Returns the number of bytes allocated by the chunk.
+*
+*	Data Members:
+*
+*		TArray<TileData> m_tiles
+*			The tiles of the chunk, row-major.
+*		int m_chunkX, m_chunkY
+*			Which chunk of the layout this is.
+*		int m_originX, m_originY
+*			The layout position of the chunk's first tile.
+*		int m_width
+*			The number of tiles in a row.
+*		int m_height
+*			The number of rows.
+**********************************************************************************************************/
+class HALVA_API DungeonChunk
+{
+public:
+
+	DungeonChunk();
+
+	int GetChunkX() const;
+	int GetChunkY() const;
+	int GetOriginX() const;
+	int GetOriginY() const;
+	int GetWidth() const;
+	int GetHeight() const;
+	TileLayoutView GetTiles();
+
+	void Reset(int ChunkX, int ChunkY, int OriginX, int OriginY, int Width, int Height);
+	bool ContainsTile(int X, int Y) const;
+	TileData GetTile(int X, int Y) const;
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	TArray<TileData> m_tiles;
+	int m_chunkX;
+	int m_chunkY;
+	int m_originX;
+	int m_originY;
+	int m_width;
+	int m_height;
+};
@@ -0,0 +1,215 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "DungeonChunkCache.h"
+
+/**********************************************************************************************************
+*	DungeonChunkCache()
+*		Purpose:	Default constructor. Results in a cache that holds nothing.
+**********************************************************************************************************/
+DungeonChunkCache::DungeonChunkCache()
+{
+	m_chunksX = 0;
+	m_chunksY = 0;
+	m_capacity = 1;
+	m_mostRecent = -1;
+	m_leastRecent = -1;
+}
+/**********************************************************************************************************
+*	void Reset(int ChunksX, int ChunksY, SIZE_T MemoryLimit, SIZE_T ChunkBytes)
+*		Purpose:	Throws out every chunk and sizes the cache for a layout of ChunksX by ChunksY chunks.
+*
+*		Parameters:
+*			int ChunksX, int ChunksY
+*				The number of chunks across and down the layout.
+*			SIZE_T MemoryLimit
+*				The most bytes the held chunks may use. At least one chunk is always held.
+*			SIZE_T ChunkBytes
+*				The bytes used by one full sized chunk.
+*
+*		Changes:
+*			m_chunks - Emptied.
+*			m_chunkSlots - One entry per chunk of the layout, all -1.
+*			m_capacity - Set from MemoryLimit.
+**********************************************************************************************************/
+void DungeonChunkCache::Reset(int ChunksX, int ChunksY, SIZE_T MemoryLimit, SIZE_T ChunkBytes)
+{
+	Empty();
+
+	m_chunksX = ChunksX > 0 ? ChunksX : 0;
+	m_chunksY = ChunksY > 0 ? ChunksY : 0;
+
+	SIZE_T capacity = ChunkBytes > 0 ? MemoryLimit / ChunkBytes : 1;
+	m_capacity = (int)FMath::Clamp<SIZE_T>(capacity, 1, (SIZE_T)FMath::Max(m_chunksX * m_chunksY, 1));
+
+	m_chunkSlots.Init(-1, m_chunksX * m_chunksY);
+}
+/**********************************************************************************************************
+*	DungeonChunk * Find(int ChunkX, int ChunkY)
+*		Purpose:	Looks up a chunk and marks it as the most recently used.
+*
+*		Parameters:
+*			int ChunkX, int ChunkY
+*				The chunk. Must be inside the layout.
+*
+*		Return:		The chunk, or nullptr if it is not held. The pointer is valid until the next Add.
+**********************************************************************************************************/
+DungeonChunk * DungeonChunkCache::Find(int ChunkX, int ChunkY)
+{
+	check(ChunkX >= 0 && ChunkY >= 0 && ChunkX < m_chunksX && ChunkY < m_chunksY);
+
+	int slot = m_chunkSlots[ChunkY * m_chunksX + ChunkX];
+
+	if (slot < 0)
+		return nullptr;
+
+	if (slot != m_mostRecent)
+	{
+		Unlink(slot);
+		LinkFirst(slot);
+	}
+
+	return &m_chunks[slot];
+}
+/**********************************************************************************************************
+*	DungeonChunk & Add(int ChunkX, int ChunkY)
+*		Purpose:	Gives a slot to a chunk. A new slot is made while there is room under the capacity,
+*					otherwise the least recently used chunk is evicted and its slot reused, keeping its
+*					tile buffer.
+*
+*		Parameters:
+*			int ChunkX, int ChunkY
+*				The chunk. Must be inside the layout and not already held.
+*
+*		Changes:
+*			m_chunks - May gain a slot.
+*			m_chunkSlots - The chunk is mapped to its slot and any evicted chunk is unmapped.
+*
+*		Return:		The chunk's slot, marked most recently used. Its tiles are left for the caller to
+*					fill. The reference is valid until the next Add.
+**********************************************************************************************************/
+DungeonChunk & DungeonChunkCache::Add(int ChunkX, int ChunkY)
+{
+	check(ChunkX >= 0 && ChunkY >= 0 && ChunkX < m_chunksX && ChunkY < m_chunksY);
+
+	int chunk = ChunkY * m_chunksX + ChunkX;
+	check(m_chunkSlots[chunk] < 0);
+
+	int slot = 0;
+
+	if (m_chunks.Num() < m_capacity)
+	{
+		slot = m_chunks.AddDefaulted();
+		m_slotPrevious.Add(-1);
+		m_slotNext.Add(-1);
+		m_slotChunk.Add(-1);
+	}
+	else
+	{
+		slot = m_leastRecent;
+		Unlink(slot);
+		m_chunkSlots[m_slotChunk[slot]] = -1;
+	}
+
+	m_slotChunk[slot] = chunk;
+	m_chunkSlots[chunk] = slot;
+	LinkFirst(slot);
+
+	return m_chunks[slot];
+}
+/**********************************************************************************************************
+*	void Empty()
+*		Purpose:	Throws out every chunk and frees their tiles. The capacity is kept.
+*
+*		Changes:
+*			m_chunks, m_slotPrevious, m_slotNext, m_slotChunk - Emptied.
+*			m_chunkSlots - Every chunk is unmapped.
+**********************************************************************************************************/
+void DungeonChunkCache::Empty()
+{
+	for (int i = 0; i < m_slotChunk.Num(); i++)
+		m_chunkSlots[m_slotChunk[i]] = -1;
+
+	m_chunks.Empty();
+	m_slotPrevious.Empty();
+	m_slotNext.Empty();
+	m_slotChunk.Empty();
+
+	m_mostRecent = -1;
+	m_leastRecent = -1;
+}
+/**********************************************************************************************************
+*	int Num()
+*		Purpose:	Getter. The number of chunks held.
+**********************************************************************************************************/
+int DungeonChunkCache::Num() const
+{
+	return m_chunks.Num();
+}
+/**********************************************************************************************************
+*	int GetCapacity()
+*		Purpose:	Getter. The most chunks that can be held at once.
+**********************************************************************************************************/
+int DungeonChunkCache::GetCapacity() const
+{
+	return m_capacity;
+}
+/**********************************************************************************************************
+*	SIZE_T GetAllocatedSize()
+*		Purpose:	Getter. The number of bytes allocated for the slots, the chunk map and every chunk's
+*					tiles.
+**********************************************************************************************************/
+SIZE_T DungeonChunkCache::GetAllocatedSize() const
+{
+	SIZE_T size = m_chunks.GetAllocatedSize() + m_slotPrevious.GetAllocatedSize() + m_slotNext.GetAllocatedSize()
+		+ m_slotChunk.GetAllocatedSize() + m_chunkSlots.GetAllocatedSize();
+
+	for (int i = 0; i < m_chunks.Num(); i++)
+		size += m_chunks[i].GetAllocatedSize();
+
+	return size;
+}
+/**********************************************************************************************************
+*	void Unlink(int Slot)
+*		Purpose:	Removes a slot from the recently used list, joining its neighbors.
+*
+*		Changes:
+*			m_slotPrevious, m_slotNext, m_mostRecent, m_leastRecent - Updated to skip Slot.
+**********************************************************************************************************/
+void DungeonChunkCache::Unlink(int Slot)
+{
+	int previous = m_slotPrevious[Slot];
+	int next = m_slotNext[Slot];
+
+	if (previous >= 0)
+		m_slotNext[previous] = next;
+	else
+		m_mostRecent = next;
+
+	if (next >= 0)
+		m_slotPrevious[next] = previous;
+	else
+		m_leastRecent = previous;
+
+	m_slotPrevious[Slot] = -1;
+	m_slotNext[Slot] = -1;
+}
+/**********************************************************************************************************
+*	void LinkFirst(int Slot)
+*		Purpose:	Puts an unlinked slot at the front of the recently used list.
+*
+*		Changes:
+*			m_slotPrevious, m_slotNext, m_mostRecent, m_leastRecent - Updated to start with Slot.
+**********************************************************************************************************/
+void DungeonChunkCache::LinkFirst(int Slot)
+{
+	m_slotPrevious[Slot] = -1;
+	m_slotNext[Slot] = m_mostRecent;
+
+	if (m_mostRecent >= 0)
+		m_slotPrevious[m_mostRecent] = Slot;
+	else
+		m_leastRecent = Slot;
+
+	m_mostRecent = Slot;
+}
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "DungeonChunk.h"
+/**********************************************************************************************************
+*	Class: DungeonChunkCache
+*
+*	Overview:
+*		Holds the most recently used chunks of a chunked DungeonLayout under a memory limit. The cache
+*		is split into as many slots as the limit has room for. When every slot is in use the least
+*		recently used chunk is thrown out to make room, and it is generated again if it is asked for
+*		later. Which slot holds a chunk is looked up by chunk index, and the slots are kept in a linked
+*		list from most to least recently used, so finding, adding and evicting are all constant time.
+*
+*		The cache does not generate chunks itself. A chunk returned by Add is empty and is filled by
+*		the owning layout.
+*
+*	Manager Functions:
+*
+*		DungeonChunkCache();
+*			Default constructor. Results in a cache that holds nothing.
+*
+*	Methods:
+*
+*		void Reset(int ChunksX, int ChunksY, SIZE_T MemoryLimit, SIZE_T ChunkBytes)
+*			Throws out every chunk and sizes the cache for a new layout.
+*		DungeonChunk * Find(int ChunkX, int ChunkY)
+*			Returns the chunk if it is held and marks it most recently used.
+*		DungeonChunk & Add(int ChunkX, int ChunkY)
+*			Gives a slot to a chunk that is not held, evicting the least recently used chunk if needed.
+*		void Empty()
+*			Throws out every chunk and frees the slots.
+*		int Num()
+*			Returns the number of chunks held.
+*		int GetCapacity()
+*			Returns the most chunks that can be held at once.
+*		SIZE_T GetAllocatedSize()
+*			Returns the number of bytes allocated by the cache and its chunks.
+*		void Unlink(int Slot)
+*			Removes a slot from the recently used list.
+*		void LinkFirst(int Slot)
+*			Puts a slot at the front of the recently used list.
+*
+*	Data Members:
+*
+*		TArray<DungeonChunk> m_chunks
+*			The slots. A slot is only added when every slot made so far is in use.
+*		TArray<int> m_slotPrevious, m_slotNext
+*			The links of each slot in the recently used list, -1 at the ends.
+*		TArray<int> m_slotChunk
+*			The chunk index held by each slot.
+*		TArray<int> m_chunkSlots
+*			The slot holding each chunk of the layout, -1 if the chunk is not held. Chunk (X, Y) has the
+*			index Y * m_chunksX + X.
+*		int m_chunksX, m_chunksY
+*			The number of chunks across and down the layout.
+*		int m_capacity
+*			The most slots the memory limit allows, never less than 1.
+*		int m_mostRecent, m_leastRecent
+*			The ends of the recently used list, -1 if it is empty.
+**********************************************************************************************************/
+class HALVA_API DungeonChunkCache
+{
+public:
+
+	DungeonChunkCache();
+
+	void Reset(int ChunksX, int ChunksY, SIZE_T MemoryLimit, SIZE_T ChunkBytes);
+	DungeonChunk * Find(int ChunkX, int ChunkY);
+	DungeonChunk & Add(int ChunkX, int ChunkY);
+	void Empty();
+	int Num() const;
+	int GetCapacity() const;
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	void Unlink(int Slot);
+	void LinkFirst(int Slot);
+
+	TArray<DungeonChunk> m_chunks;
+	TArray<int> m_slotPrevious;
+	TArray<int> m_slotNext;
+	TArray<int> m_slotChunk;
+	TArray<int> m_chunkSlots;
+	int m_chunksX;
+	int m_chunksY;
+	int m_capacity;
+	int m_mostRecent;
+	int m_leastRecent;
+};
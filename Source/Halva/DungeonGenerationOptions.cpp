@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "DungeonGenerationOptions.h"
+
+/**********************************************************************************************************
+*	FDungeonGenerationOptions()
+*		Purpose:	Constructor. The defaults reproduce the original generator.
+**********************************************************************************************************/
+FDungeonGenerationOptions::FDungeonGenerationOptions()
+{
+	ErosionMode = EErosionMode::Sequential;
+	TileSolveMode = ETileSolveMode::FullScan;
+	bParallelTileSolve = false;
+	bSplitRandomStreams = false;
+	bNearestRoomSearch = false;
+	RoomDropMode = ERoomDropMode::RandomWalk;
+	bParallelPathGeneration = false;
+	bSparseTileStorage = false;
+	bChunkedGeneration = false;
+	ChunkSize = 64;
+	ChunkCacheMegabytes = 64;
+}
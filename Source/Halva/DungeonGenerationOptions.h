@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "DungeonGenerationOptions.generated.h"
+/**********************************************************************************************************
+*	enum: EErosionMode
+*
+*	Overview:
+*		Specifies how DungeonLayout erodes the edges of rooms and paths.
+*
+*	Options:
+*		Sequential
+*			Every tile is visited in row order and eroded in place. Tiles later in the scan see the
+*			erosion of tiles earlier in the same pass.
+*		Bitboard
+*			The floor is packed into 64 bit masks and each pass erodes against the result of the
+*			previous pass, 64 tiles at a time. Much faster on large maps but gives a different layout
+*			than Sequential for the same seed.
+*		Hashed
+*			Like Bitboard, but the random number for a tile is a hash of the seed, the pass and the
+*			tile's position instead of the next number in the stream. The result does not depend on the
+*			order tiles are visited in, so passes run in parallel and any part of the dungeon can be
+*			eroded on its own. Gives a different layout than the other modes for the same seed.
+**********************************************************************************************************/
+UENUM(BlueprintType)
+enum class EErosionMode : uint8
+{
+	Sequential		UMETA(DisplayName = "Sequential"),
+	Bitboard		UMETA(DisplayName = "Bitboard"),
+	Hashed			UMETA(DisplayName = "Hashed")
+};
+/**********************************************************************************************************
+*	enum: ETileSolveMode
+*
+*	Overview:
+*		Specifies which tiles DungeonLayout runs the tile solver on.
+*
+*	Options:
+*		FullScan
+*			Every tile that is not a floor is solved.
+*		Frontier
+*			Only tiles touching a floor, found by dilating the floor by one tile, are solved. Every other
+*			tile can only ever be empty and is filled as empty in bulk. Gives the same layout as FullScan
+*			but the solve cost follows the length of the walls instead of the area of the map.
+**********************************************************************************************************/
+UENUM(BlueprintType)
+enum class ETileSolveMode : uint8
+{
+	FullScan		UMETA(DisplayName = "FullScan"),
+	Frontier		UMETA(DisplayName = "Frontier")
+};
+/**********************************************************************************************************
+*	enum: ERoomDropMode
+*
+*	Overview:
+*		Specifies how DungeonLayout picks the rooms to drop when there are more rooms than desired.
+*
+*	Options:
+*		RandomWalk
+*			Each drop walks down from the root picking one of the 4 children at random at every level.
+*			A leaf is picked with a chance of 1/4 per level above it, so leaves in shallow parts of the
+*			tree are dropped more often. A walk can land on a leaf that was already dropped, so fewer
+*			rooms than asked for may be dropped.
+*		Shuffle
+*			The live rooms are listed and a partial Fisher-Yates shuffle picks the ones to drop in one
+*			pass. Exactly enough rooms are dropped to reach the desired count and every set of rooms of
+*			that size is equally likely to be dropped. Gives a different layout than RandomWalk for the
+*			same seed.
+**********************************************************************************************************/
+UENUM(BlueprintType)
+enum class ERoomDropMode : uint8
+{
+	RandomWalk		UMETA(DisplayName = "RandomWalk"),
+	Shuffle			UMETA(DisplayName = "Shuffle")
+};
+/**********************************************************************************************************
+*	Struct:	FDungeonGenerationOptions
+*
+*	Overview:
+*		Switches that change how a DungeonLayout is generated without changing what it is made of. Only
+*		the speed and, where noted, the random choices made are affected.
+*
+*	UProperties:
+*		EErosionMode ErosionMode
+*			The algorithm used to erode rooms and paths.
+*		ETileSolveMode TileSolveMode
+*			Which tiles are run through the tile solver.
+*		bool bParallelTileSolve
+*			Solves bands of rows on worker threads. The layout is identical to the serial solve.
+*		bool bSplitRandomStreams
+*			Gives every quad tree node its own random stream split off of its parent's, instead of
+*			copying the parent's stream into all 4 children. Subtrees and rooms are then built in
+*			parallel. Gives a different layout than the shared stream for the same seed.
+*		bool bNearestRoomSearch
+*			Connects paths to the room whose closest edge really is nearest the path's point, found by
+*			a search that skips subtrees whose rooms are all farther away than the best room so far.
+*			Without it the first room below the node is used, as the original generator did. Gives a
+*			different layout for the same seed.
+*		ERoomDropMode RoomDropMode
+*			How the rooms to drop are picked.
+*		bool bParallelPathGeneration
+*			Generates the paths of each quad tree node from its own stream, made from the seed and the
+*			node's place in the tree, and generates the paths of many nodes in parallel. The layout is
+*			the same however many threads are used. Gives a different layout than the shared stream for
+*			the same seed.
+*		bool bSparseTileStorage
+*			Compacts the finished layout. The tiles are still generated in the full grid, then moved
+*			into a SparseTileLayout and the grid is freed, so only the memory kept afterwards and the
+*			walk over the built tiles follow the built area. Generating costs as much time and peak
+*			memory as without it, plus one pass to compact. The layout is unchanged.
+*		bool bChunkedGeneration
+*			Only the rooms and paths are generated up front and the full grid is never allocated. The
+*			tiles are made one square chunk at a time when asked for, so the memory used follows the
+*			number of rooms and the chunks being held rather than the size of the map. Chunks are always
+*			eroded with EErosionMode::Hashed, the only mode that can erode part of the map on its own,
+*			and match a full layout generated with it.
+*		int32 ChunkSize
+*			The width and height in tiles of each chunk when bChunkedGeneration is set. Sizes under 16
+*			are treated as 16.
+*		int32 ChunkCacheMegabytes
+*			The most memory the chunks held by a chunked layout may use. The least recently used chunks
+*			are thrown out past this and made again if they are asked for later. At least one chunk is
+*			always held.
+**********************************************************************************************************/
+USTRUCT(BlueprintType)
+struct HALVA_API FDungeonGenerationOptions
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		EErosionMode ErosionMode;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		ETileSolveMode TileSolveMode;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		bool bParallelTileSolve;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		bool bSplitRandomStreams;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		bool bNearestRoomSearch;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		ERoomDropMode RoomDropMode;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		bool bParallelPathGeneration;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		bool bSparseTileStorage;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		bool bChunkedGeneration;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		int32 ChunkSize;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generation")
+		int32 ChunkCacheMegabytes;
+
+	FDungeonGenerationOptions();
+};
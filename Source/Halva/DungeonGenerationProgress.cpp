@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "DungeonGenerationProgress.h"
+
+/**********************************************************************************************************
+*	DungeonGenerationProgress()
+*		Purpose:	Default constructor. No progress has been made and nothing is cancelled.
+**********************************************************************************************************/
+DungeonGenerationProgress::DungeonGenerationProgress()
+{
+	m_progress.Set(0);
+	m_cancelled.Set(0);
+	m_done.Set(0);
+}
+/**********************************************************************************************************
+*	float GetProgress()
+*		Purpose:	Getter.
+*
+*		Return:		How far generation has got, from 0 to 1.
+**********************************************************************************************************/
+float DungeonGenerationProgress::GetProgress() const
+{
+	return (float)m_progress.GetValue() / m_PROGRESS_STEPS;
+}
+/**********************************************************************************************************
+*	void SetProgress(float Progress)
+*		Purpose:	Setter. Progress is clamped between 0 and 1.
+**********************************************************************************************************/
+void DungeonGenerationProgress::SetProgress(float Progress)
+{
+	m_progress.Set(FMath::RoundToInt(FMath::Clamp(Progress, 0.0f, 1.0f) * m_PROGRESS_STEPS));
+}
+/**********************************************************************************************************
+*	void Cancel()
+*		Purpose:	Asks the generation to stop. It stops at its next check, not right away.
+*
+*		Changes:
+*			m_cancelled - Set to 1.
+**********************************************************************************************************/
+void DungeonGenerationProgress::Cancel()
+{
+	m_cancelled.Set(1);
+}
+/**********************************************************************************************************
+*	bool IsCancelled()
+*		Purpose:	Checks if Cancel has been called.
+*
+*		Return:		True if the generation should stop.
+**********************************************************************************************************/
+bool DungeonGenerationProgress::IsCancelled() const
+{
+	return m_cancelled.GetValue() != 0;
+}
+/**********************************************************************************************************
+*	void SetDone()
+*		Purpose:	Marks the generation as finished. Called once the result has been used or thrown
+*					away, whether the generation completed or was cancelled.
+*
+*		Changes:
+*			m_done - Set to 1.
+**********************************************************************************************************/
+void DungeonGenerationProgress::SetDone()
+{
+	m_done.Set(1);
+}
+/**********************************************************************************************************
+*	bool IsDone()
+*		Purpose:	Checks if SetDone has been called.
+*
+*		Return:		True if the generation has finished.
+**********************************************************************************************************/
+bool DungeonGenerationProgress::IsDone() const
+{
+	return m_done.GetValue() != 0;
+}
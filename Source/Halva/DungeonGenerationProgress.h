@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+/**********************************************************************************************************
+*	Class: DungeonGenerationProgress
+*
+*	Overview:
+*		Shared between a DungeonLayout being generated on another thread and whoever is waiting on it.
+*		The layout reports how far it has got after each stage of generation and checks if it has been
+*		cancelled between stages. A cancelled layout stops at the next check and is left only partly
+*		generated. Every method can be called from any thread.
+*
+*	Manager Functions:
+*
+*		DungeonGenerationProgress();
+*			Default constructor. Results in a generation that has not started or been cancelled.
+*
+*	Mutators:
+*
+*		Progress
+*			-Get
+*			-Set
+*
+*	Methods:
+*
+*		void Cancel()
+*			Asks the generation to stop at its next check.
+*		bool IsCancelled()
+*			Returns if Cancel has been called.
+*		void SetDone()
+*			Marks the generation as finished, whether it completed or was cancelled.
+*		bool IsDone()
+*			Returns if SetDone has been called.
+*
+*	Data Members:
+*
+*		FThreadSafeCounter m_progress
+*			How far generation has got, in steps of 1 / m_PROGRESS_STEPS.
+*		FThreadSafeCounter m_cancelled
+*			1 once Cancel is called.
+*		FThreadSafeCounter m_done
+*			1 once SetDone is called.
+*		static const int m_PROGRESS_STEPS
+*			The number of steps m_progress counts from 0 to 1 in.
+**********************************************************************************************************/
+class HALVA_API DungeonGenerationProgress
+{
+public:
+
+	DungeonGenerationProgress();
+
+	float GetProgress() const;
+	void SetProgress(float Progress);
+
+	void Cancel();
+	bool IsCancelled() const;
+	void SetDone();
+	bool IsDone() const;
+
+private:
+
+	FThreadSafeCounter m_progress;
+	FThreadSafeCounter m_cancelled;
+	FThreadSafeCounter m_done;
+
+	static const int m_PROGRESS_STEPS = 10000;
+};
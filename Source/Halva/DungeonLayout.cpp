@@ -2,6 +2,7 @@
 
 #include "Halva.h"
 #include "DungeonLayout.h"
+#include "Async/ParallelFor.h"
 
 // Define an error log.
 //DEFINE_LOG_CATEGORY(DungeonBuilding);
@@ -13,15 +14,26 @@
 DungeonLayout::DungeonLayout()
 {
 	m_paths = TArray<Quad>();
+	m_floorSpans = TArray<TileSpan>();
 	m_minimumRoomSize = FVector(0, 0, 0);
 	m_dungeonDimensions = FVector(0, 0, 0);
 	m_targetNumRooms = 0;
-	m_quadTreeRoot = QuadTreeNode(0, Quad(), m_minimumRoomSize, FRandomStream(0));
+	QuadTreeNode emptyRoot(0, Quad(), m_minimumRoomSize, FRandomStream(0));
+	m_linearTree = LinearQuadTree(&emptyRoot);
 	m_pathWidth = 0;
 	m_dungeonLayout = nullptr;
+	m_layoutWidth = 0;
+	m_layoutHeight = 0;
 	m_erosionPasses = 0;
 	m_erosionChance = 0;
 	m_randomStream = FRandomStream(0);
+	m_seed = 0;
+	m_initialStream = FRandomStream(0);
+	m_roomsStream = FRandomStream(0);
+	m_pathsStream = FRandomStream(0);
+	m_generated = false;
+	m_progress = nullptr;
+	m_options = FDungeonGenerationOptions();
 }
 /**********************************************************************************************************
 *	DungeonLayout(...)
@@ -42,33 +54,43 @@ DungeonLayout::DungeonLayout()
 *				The number of times to erode walls.
 *			float ErosionChance
 *				The chance a wall is eroded.
+*			FRandomStream RNG
+*				The random stream all random choices are made with.
+*			FDungeonGenerationOptions Options
+*				The algorithms to use for each step of generation.
+*			DungeonGenerationProgress * Progress
+*				If not nullptr, told when each stage is done and checked between stages. If it is
+*				cancelled the layout is left part way and is not marked generated.
 **********************************************************************************************************/
-DungeonLayout::DungeonLayout(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth, int ErosionPasses, float ErosionChance, FRandomStream RNG)
+DungeonLayout::DungeonLayout(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth, int ErosionPasses, float ErosionChance, FRandomStream RNG, FDungeonGenerationOptions Options, DungeonGenerationProgress * Progress)
 {
-	// Get the number of cuts to make. This is log4(DesiredRooms) rounded up.
-	int Depth = 1;
+	m_progress = Progress;
 
-	if (DesiredRooms > 0)
-		Depth = ceil(log(DesiredRooms) / log(4));
+	// Get the number of cuts to make.
+	int Depth = GetTreeDepth(DesiredRooms);
 
 	// remove 1 from each edge for walls.
 	Quad DungeonBounds = Quad(DungeonSize - FVector(2, 2, 0), FVector(1, 1, 0));
 
-	m_quadTreeRoot = QuadTreeNode(Depth, DungeonBounds, MinimumRoomSize, RNG);
+	// The generation steps only walk the flattened tree, so the pointer tree and the arena its nodes
+	// live in are freed as soon as it has been flattened. The root goes before the arena.
+	{
+		QuadTreeNodeArena nodeArena;
+		QuadTreeNode quadTreeRoot(Depth, DungeonBounds, MinimumRoomSize, RNG, Options.bSplitRandomStreams, &nodeArena);
+
+		m_linearTree = LinearQuadTree(&quadTreeRoot);
+	}
 
 	m_paths = TArray<Quad>();
+	m_floorSpans = TArray<TileSpan>();
 
 	m_targetNumRooms = DesiredRooms;
 	m_dungeonLayout = nullptr;
 	m_dungeonDimensions = DungeonSize;
+	m_options = Options;
 
-	m_dungeonLayout = new TileData *[m_dungeonDimensions.Y];
-
-	for (int i = 0; i < m_dungeonDimensions.Y; i++)
-	{
-		m_dungeonLayout[i] = new TileData[m_dungeonDimensions.X];
-	}
 	// Initialize dungeon layout.
+	AllocateDungeonLayout();
 	ClearDungeonLayout();
 
 	m_minimumRoomSize = MinimumRoomSize;
@@ -78,20 +100,22 @@ DungeonLayout::DungeonLayout(FVector DungeonSize, FVector MinimumRoomSize, int D
 	m_erosionChance = ErosionChance;
 
 	m_randomStream = RNG;
+	m_seed = RNG.GetInitialSeed();
+	m_initialStream = RNG;
+	m_roomsStream = RNG;
+	m_pathsStream = RNG;
+	m_generated = false;
 
 	// Verify all operands are valid before attempting to make the dungeon.
-	bool OKToGenerate = true;
-
-	// Verify that the dungeon will have area.
-	OKToGenerate = OKToGenerate && floor(DungeonSize.X) > 0 && floor(DungeonSize.Y) > 0;
-	// Verify the paths will have area.
-	OKToGenerate = OKToGenerate && PathWidth > 0;
+	bool OKToGenerate = CanGenerate(DungeonSize, PathWidth);
 
-	if (OKToGenerate)
+	if (OKToGenerate && FinishStage(EDungeonStage::Tree))
 	{
 		// Create Dungeon.
 		GenerateDungeonLayout();
 	}
+
+	m_progress = nullptr;
 }
 /**********************************************************************************************************
 *	DungeonLayout(const DungeonLayout & Source)
@@ -104,6 +128,12 @@ DungeonLayout::DungeonLayout(FVector DungeonSize, FVector MinimumRoomSize, int D
 DungeonLayout::DungeonLayout(const DungeonLayout & Source)
 {
 	m_paths = Source.m_paths;
+	m_floorSpans = Source.m_floorSpans;
+	m_sparseLayout = Source.m_sparseLayout;
+	m_chunkRects = Source.m_chunkRects;
+	m_chunkRowFirstRect = Source.m_chunkRowFirstRect;
+	m_chunkCache = Source.m_chunkCache;
+	m_floorEdits = Source.m_floorEdits;
 	m_pathWidth = Source.m_pathWidth;
 	m_dungeonDimensions = Source.m_dungeonDimensions;
 	m_minimumRoomSize = Source.m_minimumRoomSize;
@@ -111,32 +141,69 @@ DungeonLayout::DungeonLayout(const DungeonLayout & Source)
 	m_erosionPasses = Source.m_erosionPasses;
 	m_erosionChance = Source.m_erosionChance;
 	m_randomStream = Source.m_randomStream;
-	m_quadTreeRoot = Source.m_quadTreeRoot;
-
-	// Gets the dimensions of the level.
-	FVector levelDimensions(m_quadTreeRoot.GetQuad().GetBounds());
-
-	// Throw out any decimal the user might have entered.
-	int xTileNumber = (int)floor(levelDimensions.X);
-	int yTileNumber = (int)floor(levelDimensions.Y);
+	m_seed = Source.m_seed;
+	m_initialStream = Source.m_initialStream;
+	m_roomsStream = Source.m_roomsStream;
+	m_pathsStream = Source.m_pathsStream;
+	m_generated = Source.m_generated;
+	m_progress = nullptr;
+	m_options = Source.m_options;
+	m_linearTree = Source.m_linearTree;
 
 	m_dungeonLayout = nullptr;
+	m_layoutWidth = 0;
+	m_layoutHeight = 0;
 
-	// make a non-contiguous 2d array thing that is the same size as the old one.
-	// create an array of TileData array pointers.
-	if (yTileNumber > 0 && xTileNumber > 0)
-	{
-		m_dungeonLayout = new TileData *[yTileNumber];
-
-		// create a Tile Data array for each element of the TileData pointer array.
-		for (int i = 0; i < yTileNumber; i++)
-			m_dungeonLayout[i] = new TileData[xTileNumber];
+	// The layout is one contiguous block so it can be copied in one go. A sparse layout has no
+	// dense tiles to copy and a chunked layout only needs its size.
+	if (Source.m_dungeonLayout != nullptr || Source.IsChunked())
+		AllocateDungeonLayout();
 
-		// copy the values over.
-		for (int y = 0; y < yTileNumber; y++)
-			for (int x = 0; x < xTileNumber; x++)
-				m_dungeonLayout[y][x] = Source.m_dungeonLayout[y][x];
-	}
+	if (Source.m_dungeonLayout != nullptr)
+		FMemory::Memcpy(m_dungeonLayout, Source.m_dungeonLayout, sizeof(TileData) * m_layoutWidth * m_layoutHeight);
+}
+/**********************************************************************************************************
+*	DungeonLayout(DungeonLayout && Source)
+*		Purpose:	Move constructor. Takes ownership of Source's quad tree and tiles instead of copying
+*					them. Source is left as an empty layout.
+*
+*		Parameters:
+*			DungeonLayout && Source
+*				The object to move from.
+**********************************************************************************************************/
+DungeonLayout::DungeonLayout(DungeonLayout && Source)
+{
+	m_paths = MoveTemp(Source.m_paths);
+	m_floorSpans = MoveTemp(Source.m_floorSpans);
+	m_sparseLayout = MoveTemp(Source.m_sparseLayout);
+	m_chunkRects = MoveTemp(Source.m_chunkRects);
+	m_chunkRowFirstRect = MoveTemp(Source.m_chunkRowFirstRect);
+	m_chunkCache = MoveTemp(Source.m_chunkCache);
+	m_floorEdits = MoveTemp(Source.m_floorEdits);
+	m_pathWidth = Source.m_pathWidth;
+	m_dungeonDimensions = Source.m_dungeonDimensions;
+	m_minimumRoomSize = Source.m_minimumRoomSize;
+	m_targetNumRooms = Source.m_targetNumRooms;
+	m_erosionPasses = Source.m_erosionPasses;
+	m_erosionChance = Source.m_erosionChance;
+	m_randomStream = Source.m_randomStream;
+	m_seed = Source.m_seed;
+	m_initialStream = Source.m_initialStream;
+	m_roomsStream = Source.m_roomsStream;
+	m_pathsStream = Source.m_pathsStream;
+	m_generated = Source.m_generated;
+	m_progress = nullptr;
+	m_options = Source.m_options;
+	m_linearTree = MoveTemp(Source.m_linearTree);
+
+	m_dungeonLayout = Source.m_dungeonLayout;
+	m_layoutWidth = Source.m_layoutWidth;
+	m_layoutHeight = Source.m_layoutHeight;
+
+	Source.m_dungeonLayout = nullptr;
+	Source.m_layoutWidth = 0;
+	Source.m_layoutHeight = 0;
+	Source.m_generated = false;
 }
 /**********************************************************************************************************
 *	~DungeonLayout()
@@ -144,19 +211,7 @@ DungeonLayout::DungeonLayout(const DungeonLayout & Source)
 **********************************************************************************************************/
 DungeonLayout::~DungeonLayout()
 {
-	if (m_dungeonLayout != nullptr)
-	{
-		FVector levelDimensions(m_quadTreeRoot.GetQuad().GetBounds());
-
-		// Throw out any decimal the user might have entered.
-		int yTileNumber = (int)floor(levelDimensions.Y);
-
-		for (int i = 0; i < yTileNumber; i++)
-			delete[] m_dungeonLayout[i];
-
-		delete[] m_dungeonLayout;
-		m_dungeonLayout = nullptr;
-	}
+	FreeDungeonLayout();
 }
 /**********************************************************************************************************
 *	DungeonLayout & operator=(const DungeonLayout & Source)
@@ -170,18 +225,15 @@ DungeonLayout & DungeonLayout::operator=(const DungeonLayout & Source)
 {
 	if (&Source != this)
 	{
-		if (m_dungeonLayout != nullptr)
-		{
-			for (int i = 0; i < m_dungeonDimensions.Y; i++)
-			{
-				delete[] m_dungeonLayout[i];
-				m_dungeonLayout[i] = nullptr;
-			}
-			delete[] m_dungeonLayout;
-			m_dungeonLayout = nullptr;
-		}
+		FreeDungeonLayout();
 
 		m_paths = Source.m_paths;
+		m_floorSpans = Source.m_floorSpans;
+		m_sparseLayout = Source.m_sparseLayout;
+		m_chunkRects = Source.m_chunkRects;
+		m_chunkRowFirstRect = Source.m_chunkRowFirstRect;
+		m_chunkCache = Source.m_chunkCache;
+		m_floorEdits = Source.m_floorEdits;
 		m_pathWidth = Source.m_pathWidth;
 		m_dungeonDimensions = Source.m_dungeonDimensions;
 		m_minimumRoomSize = Source.m_minimumRoomSize;
@@ -189,34 +241,93 @@ DungeonLayout & DungeonLayout::operator=(const DungeonLayout & Source)
 		m_erosionPasses = Source.m_erosionPasses;
 		m_erosionChance = Source.m_erosionChance;
 		m_randomStream = Source.m_randomStream;
-		m_quadTreeRoot = Source.m_quadTreeRoot;
-
-		if (m_dungeonDimensions.Y > 0 && m_dungeonDimensions.X > 0)
-		{
-			m_dungeonLayout = new TileData *[m_dungeonDimensions.Y];
-
-			// create a Tile Data array for each element of the TileData pointer array.
-			for (int i = 0; i < m_dungeonDimensions.Y; i++)
-				m_dungeonLayout[i] = new TileData[m_dungeonDimensions.X];
-
-			// copy the values over.
-			for (int y = 0; y < m_dungeonDimensions.Y; y++)
-				for (int x = 0; x < m_dungeonDimensions.X; x++)
-					m_dungeonLayout[y][x] = Source.m_dungeonLayout[y][x];
-		}
-
+		m_seed = Source.m_seed;
+		m_initialStream = Source.m_initialStream;
+		m_roomsStream = Source.m_roomsStream;
+		m_pathsStream = Source.m_pathsStream;
+		m_generated = Source.m_generated;
+		m_options = Source.m_options;
+		m_linearTree = Source.m_linearTree;
+
+		if (Source.m_dungeonLayout != nullptr || Source.IsChunked())
+			AllocateDungeonLayout();
+
+		if (Source.m_dungeonLayout != nullptr)
+			FMemory::Memcpy(m_dungeonLayout, Source.m_dungeonLayout, sizeof(TileData) * m_layoutWidth * m_layoutHeight);
+	}
 
+	return *this;
+}
+/**********************************************************************************************************
+*	DungeonLayout & operator=(DungeonLayout && Source)
+*		Purpose:	Move assignment. Frees this layout and takes ownership of Source's quad tree and tiles
+*					without copying them. Source is left as an empty layout.
+*
+*		Parameters:
+*			DungeonLayout && Source
+*				The object to move from.
+**********************************************************************************************************/
+DungeonLayout & DungeonLayout::operator=(DungeonLayout && Source)
+{
+	if (&Source != this)
+	{
+		FreeDungeonLayout();
+
+		m_paths = MoveTemp(Source.m_paths);
+		m_floorSpans = MoveTemp(Source.m_floorSpans);
+		m_sparseLayout = MoveTemp(Source.m_sparseLayout);
+		m_chunkRects = MoveTemp(Source.m_chunkRects);
+		m_chunkRowFirstRect = MoveTemp(Source.m_chunkRowFirstRect);
+		m_chunkCache = MoveTemp(Source.m_chunkCache);
+		m_floorEdits = MoveTemp(Source.m_floorEdits);
+		m_pathWidth = Source.m_pathWidth;
+		m_dungeonDimensions = Source.m_dungeonDimensions;
+		m_minimumRoomSize = Source.m_minimumRoomSize;
+		m_targetNumRooms = Source.m_targetNumRooms;
+		m_erosionPasses = Source.m_erosionPasses;
+		m_erosionChance = Source.m_erosionChance;
+		m_randomStream = Source.m_randomStream;
+		m_seed = Source.m_seed;
+		m_initialStream = Source.m_initialStream;
+		m_roomsStream = Source.m_roomsStream;
+		m_pathsStream = Source.m_pathsStream;
+		m_generated = Source.m_generated;
+		m_options = Source.m_options;
+		m_linearTree = MoveTemp(Source.m_linearTree);
+
+		m_dungeonLayout = Source.m_dungeonLayout;
+		m_layoutWidth = Source.m_layoutWidth;
+		m_layoutHeight = Source.m_layoutHeight;
+
+		Source.m_dungeonLayout = nullptr;
+		Source.m_layoutWidth = 0;
+		Source.m_layoutHeight = 0;
+		Source.m_generated = false;
 	}
 
 	return *this;
 }
 /**********************************************************************************************************
-*	TileData ** GetDungeonLayout()
-*		Purpose:	Getter.
+*	TileLayoutView GetDungeonLayout()
+*		Purpose:	Getter. Returns a view over the row-major tile buffer. The view is invalidated by
+*					anything that reallocates the layout such as SetDungeonDimensions or assignment. Sparse
+*					and chunked layouts have no buffer and return an empty view.
+**********************************************************************************************************/
+TileLayoutView DungeonLayout::GetDungeonLayout()
+{
+	if (m_dungeonLayout == nullptr)
+		return TileLayoutView();
+
+	return TileLayoutView(m_dungeonLayout, m_layoutWidth, m_layoutHeight);
+}
+/**********************************************************************************************************
+*	TileData & GetTile(int X, int Y)
+*		Purpose:	Getter. Bounds checked access to the tile at (X, Y).
 **********************************************************************************************************/
-TileData ** DungeonLayout::GetDungeonLayout()
+TileData & DungeonLayout::GetTile(int X, int Y)
 {
-	return m_dungeonLayout;
+	check(m_dungeonLayout != nullptr && IsValidTile(X, Y));
+	return m_dungeonLayout[Y * m_layoutWidth + X];
 }
 /**********************************************************************************************************
 *	FVector GetDungeonDimensions()
@@ -236,28 +347,17 @@ FVector DungeonLayout::GetDungeonDimensions()
 void DungeonLayout::SetDungeonDimensions(FVector DungeonDimensions)
 {
 	// Clear m_dungeonLayout.
-	if (m_dungeonLayout != nullptr)
-	{
-		for (int i = 0; i < m_dungeonDimensions.Y; i++)
-		{
-			if (m_dungeonLayout[i] != nullptr)
-				delete[] m_dungeonLayout[i];
-		}
-
-		delete[] m_dungeonLayout;
-		m_dungeonLayout = nullptr;
-	}
+	FreeDungeonLayout();
 
-	// Set new size.
+	// Set new size. Any chunks were made for the old size.
 	m_dungeonDimensions = DungeonDimensions;
+	m_chunkRects.Empty();
+	m_chunkRowFirstRect.Empty();
+	m_chunkCache.Empty();
+	m_floorEdits.Empty();
 
 	//Rebuild dungeonLayout.
-	m_dungeonLayout = new TileData *[m_dungeonDimensions.Y];
-
-	for (int i = 0; i < m_dungeonDimensions.Y; i++)
-	{
-		m_dungeonLayout[i] = new TileData[m_dungeonDimensions.X];
-	}
+	AllocateDungeonLayout();
 
 	// Initialize
 	ClearDungeonLayout();
@@ -295,369 +395,1515 @@ void DungeonLayout::SetPathWidth(int PathWidth)
 	m_pathWidth = PathWidth;
 }
 /**********************************************************************************************************
-*	int CountRooms()
-*		Purpose:	Counts the rooms in the dungeon.
-*
-*		Return:
-*			The number of rooms in the dungeon.
+*	const TArray<TileSpan> & GetFloorSpans()
+*		Purpose:	Getter. The row spans of every room and path, before erosion.
 **********************************************************************************************************/
-int DungeonLayout::CountRooms()
+const TArray<TileSpan> & DungeonLayout::GetFloorSpans() const
 {
-	return CountRoomsRecursive(&m_quadTreeRoot);
+	return m_floorSpans;
 }
 /**********************************************************************************************************
-*	int GetListOfAllRooms()
-*		Purpose:	Gets a list of every room in the dungeon. This is returned by value and modifications
-*					to this list do not affect the dungeon.
-*
-*		Return:
-*			A TArray of Quads containing every room in the dungeon.
+*	const SparseTileLayout & GetSparseLayout()
+*		Purpose:	Getter. Only holds the tiles if IsSparse() is true.
 **********************************************************************************************************/
-TArray<Quad> DungeonLayout::GetListOfAllRooms()
+const SparseTileLayout & DungeonLayout::GetSparseLayout() const
 {
-	return GetListOfAllRoomsRecursive(&m_quadTreeRoot);
+	return m_sparseLayout;
 }
 /**********************************************************************************************************
-*	void GenerateDungeonLayout()
-*		Purpose:	Generates a complete dungeon from start to finish. The finished result will be stored
-*					in the 2D array m_dungeonLayout. If a layout already exists, it will be replaced with
-*					a new one.
-*
-*		Changes:
-*			m_rooms - Will be populated with a room for each quad in m_quadTreeRoot.
-*			m_paths - Paths will be generated between rooms and stored here.
-*			m_dungeonLayout - A new layout will be generated and stored here.
+*	int GetChunkSize()
+*		Purpose:	Getter. The width and height in tiles of a chunk, see m_options.ChunkSize.
 **********************************************************************************************************/
-void DungeonLayout::GenerateDungeonLayout()
+int DungeonLayout::GetChunkSize() const
 {
-	GenerateRooms();
-	DropRooms();
-	GeneratePaths();
-	CreateRoomLayout();
-	ErodeRoomLayout();
-	CreateTiles();
+	return FMath::Max(m_options.ChunkSize, m_MINIMUM_CHUNK_SIZE);
 }
 /**********************************************************************************************************
-*	void GenerateRooms()
-*		Purpose:	Populates m_rooms with a random sized room for each child quad in m_QuadTreeRoot. This
-*					room will be no smaller than m_minimumRoomSize including walls. A room will be
-*					generated for every quad regardless of if it is used in the final layout or not.
-*
-*		Changes:
-*			m_rooms - Will be populated with a room for each quad in m_quadTreeRoot.
+*	int GetNumChunksX()
+*		Purpose:	Getter. The number of chunks across the layout, 0 if the layout is not chunked or has not
+*					been generated.
 **********************************************************************************************************/
-void DungeonLayout::GenerateRooms()
+int DungeonLayout::GetNumChunksX() const
 {
-	GenerateRoomRecursive(&m_quadTreeRoot);
+	if (!IsChunked() || m_chunkRowFirstRect.Num() == 0)
+		return 0;
+
+	return (m_layoutWidth + GetChunkSize() - 1) / GetChunkSize();
 }
 /**********************************************************************************************************
-*	void DropRooms()
-*		Purpose:	Picks random rooms and removes them from the list of rooms until m_targetNumberRooms
-*					is reached. If m_targetNumberRooms is larger than the number of existing rooms, no
-*					action is performed.
+*	int GetNumChunksY()
+*		Purpose:	Getter. The number of chunks down the layout, 0 if the layout is not chunked or has not
+*					been generated.
+**********************************************************************************************************/
+int DungeonLayout::GetNumChunksY() const
+{
+	if (!IsChunked() || m_chunkRowFirstRect.Num() == 0)
+		return 0;
+
+	return (m_layoutHeight + GetChunkSize() - 1) / GetChunkSize();
+}
+/**********************************************************************************************************
+*	const DungeonChunk & GetChunk(int ChunkX, int ChunkY)
+*		Purpose:	Getter. Returns the tiles of a chunk, generating them if they are not in m_chunkCache.
+*					Generating a chunk can evict the least recently used chunk to stay under
+*					m_options.ChunkCacheMegabytes.
+*
+*		Parameters:
+*			int ChunkX, int ChunkY
+*				The chunk. Must be inside the layout, which must be chunked.
 *
 *		Changes:
-*			m_rooms - Will be populated with a room for each quad in m_quadTreeRoot.
+*			m_chunkCache - Holds the chunk as the most recently used.
+*
+*		Return:		The chunk. The reference is valid until the next call to GetChunk.
 **********************************************************************************************************/
-void DungeonLayout::DropRooms()
+const DungeonChunk & DungeonLayout::GetChunk(int ChunkX, int ChunkY)
 {
-	int roomCount = CountRooms();
+	check(IsChunked());
 
-	while (roomCount > m_targetNumRooms)
+	DungeonChunk * chunk = m_chunkCache.Find(ChunkX, ChunkY);
+
+	if (chunk == nullptr)
 	{
-		DropRandomRoomRecursive(&m_quadTreeRoot);
-		roomCount--;
+		chunk = &m_chunkCache.Add(ChunkX, ChunkY);
+		GenerateChunk(ChunkX, ChunkY, *chunk);
 	}
+
+	return *chunk;
 }
 /**********************************************************************************************************
-*	void GenerateRooms()
-*		Purpose:	Populates m_rooms with a random sized room for each child quad in m_QuadTreeRoot. This
-*					room will be no smaller than m_minimumRoomSize including walls. A room will be
-*					generated for every quad regardless of if it is used in the final layout or not.
+*	int CountRooms()
+*		Purpose:	Counts all rooms that have not been dropped. The count is kept as rooms are made and
+*					dropped, so this is O(1).
 *
-*		Changes:
-*			m_rooms - Will be populated with a room for each quad in m_quadTreeRoot.
+*		Return:		The number of rooms in the dungeon.
 **********************************************************************************************************/
-void DungeonLayout::GeneratePaths()
+int DungeonLayout::CountRooms() const
 {
-	m_paths.Empty();
-	GeneratePathsRecursive(&m_quadTreeRoot);
+	return m_linearTree.NumRooms();
 }
 /**********************************************************************************************************
-*	void CreateRoomLayout()
-*		Purpose:	Passes through each room and path in m_rooms and m_paths and assigns them as a floor
-*					in the 2D array m_dungeonLayout. For example, If a room includes the point (33,44)
-*					the value m_dungeonLayout[44][33] will be set to floor. All other tiles not in a room
-*					or path are set to empty.
+*	void ForEachRoom(TFunctionRef<void(const Quad &)> Visitor)
+*		Purpose:	Calls Visitor on every room that has not been dropped, in depth first order. Nothing
+*					is allocated, so this should be used over GetListOfAllRooms when the rooms are only
+*					being read.
 *
-*		Changes:
-*			m_dungeonLayout - The values are changed depending on if a room or path overlaps with the
-*				array location.
+*		Parameters:
+*			TFunctionRef<void(const Quad &)> Visitor
+*				Called once per room. The room must not be kept past the call.
 **********************************************************************************************************/
-void DungeonLayout::CreateRoomLayout()
+void DungeonLayout::ForEachRoom(TFunctionRef<void(const Quad &)> Visitor) const
 {
-	ClearDungeonLayout();
+	for (int i = 0; i < m_linearTree.NumLeaves(); i++)
+	{
+		const LinearQuadTreeNode & leaf = m_linearTree.GetLeaf(i);
 
-	int roomCount = CountRooms();
-	
-	TArray<Quad> listOfRooms = GetListOfAllRooms();
+		if (leaf.HasRoom())
+			Visitor(leaf.room);
+	}
+}
+/**********************************************************************************************************
+*	TArray<Quad> GetListOfAllRooms()
+*		Purpose:	Makes a list of every room that has not been dropped, in depth first order. Use
+*					ForEachRoom instead if a copy of the rooms is not needed.
+*
+*		Return:		The rooms in the dungeon.
+**********************************************************************************************************/
+TArray<Quad> DungeonLayout::GetListOfAllRooms() const
+{
+	TArray<Quad> allRooms = TArray<Quad>();
+	allRooms.Reserve(CountRooms());
 
-	for (int i = 0; i < listOfRooms.Num(); i++)
-		CreateFloorQuad(listOfRooms[i]);
+	ForEachRoom([&allRooms](const Quad & Room)
+	{
+		allRooms.Add(Room);
+	});
 
-	for (int i = 0; i < m_paths.Num(); i++)
-		CreateFloorQuad(m_paths[i]);
+	return allRooms;
 }
 /**********************************************************************************************************
-*	void ErodeRoomLayout()
-*		Purpose:	Causes each empty adjacent to a floor tile to have a chance to be replaced with a
-*					floor tile. The process is then repeated for erosion passes times. This allows semi
-*					random looking rooms to look natural.
-*		Changes:
-*			m_dungeonLayout - The values of tiles touching floor tiles have a chance to become floor tiles.
+*	TArray<TileRect> GetFloorRects()
+*		Purpose:	Lists the tiles filled by each room and then each path, the same order
+*					CreateRoomLayout fills them in. Quads with no tiles inside the layout are left out.
+*					Only the tree and paths are needed, so this can be used before any tiles are made.
+*
+*		Return:		The tiles of each room and path.
 **********************************************************************************************************/
-void DungeonLayout::ErodeRoomLayout()
+TArray<TileRect> DungeonLayout::GetFloorRects() const
 {
-	// If no erosion to be done.
-	if (m_erosionPasses == 0 || m_erosionChance == 0)
-		return;
+	TArray<TileRect> floorRects;
+	floorRects.Reserve(CountRooms() + m_paths.Num());
 
-	// edges cannot be eroded.
-	bool edge = false;
-
-	// for each pass
-	for (int pass = 0; pass < m_erosionPasses; pass++)
+	ForEachRoom([this, &floorRects](const Quad & Room)
 	{
-		for (int y = 0; y < m_dungeonDimensions.Y; y++)
-		{
-			for (int x = 0; x < m_dungeonDimensions.X; x++)
-			{
-				edge = false;
-
-				int adjacentFloorTiles = 0;
+		TileRect tiles = GetFloorQuadTiles(Room);
 
-				// Check adjacent tiles for floor tile count
-				for (int adjY = -1; adjY <= 1 && !edge; adjY++)
-				{
-					for (int adjX = -1; adjX <= 1 && !edge; adjX++)
-					{
-						// XOR - get tiles adjacent to the center.
-						if ((adjX != 0) != (adjY != 0))
-						{
-							// range check.
-							if (y + adjY >= 0 && x + adjX >= 0 && y + adjY < m_dungeonDimensions.Y && x + adjX < m_dungeonDimensions.X)
-							{
-								if (m_dungeonLayout[y + adjY][x + adjX].tileType == floorTile)
-									adjacentFloorTiles++;
-							}
-							else
-								edge = true;
-						}
-					}
-				}
+		if (!tiles.IsEmpty())
+			floorRects.Add(tiles);
+	});
 
-				// The more floor tiles the tile is touching, the more likely it is to be
-				// eroded. This will cause a more rounder look.
-				if (!edge && m_randomStream.FRand() * 100 < m_erosionChance * adjacentFloorTiles)
-				{
-					m_dungeonLayout[y][x].tileType = floorTile;
-					m_dungeonLayout[y][x].tileRotation = FRotator::ZeroRotator;
-				}
-			}
+	for (int i = 0; i < m_paths.Num(); i++)
+	{
+		TileRect tiles = GetFloorQuadTiles(m_paths[i]);
 
-		}
+		if (!tiles.IsEmpty())
+			floorRects.Add(tiles);
 	}
+
+	return floorRects;
 }
 /**********************************************************************************************************
-*	void CreateTiles()
-*		Purpose:	Scans through each tile on the map and picks which tile will best fit the current
-*					location. The tile's type and rotation will be set to the tile that best solves the
-*					given scenario.
+*	bool IsValidTile(int X, int Y)
+*		Purpose:	Checks if the location given is inside the dungeon layout.
+*
+*		Return:
+*			True if (X, Y) can be used to index the dungeon layout.
+**********************************************************************************************************/
+bool DungeonLayout::IsValidTile(int X, int Y) const
+{
+	return X >= 0 && Y >= 0 && X < m_layoutWidth && Y < m_layoutHeight;
+}
+/**********************************************************************************************************
+*	bool IsSparse()
+*		Purpose:	Checks if the tiles have been moved into m_sparseLayout. If so m_dungeonLayout is
+*					freed, GetDungeonLayout returns an empty view and the tiles must be read from
+*					GetSparseLayout instead.
+*
+*		Return:		True if the tiles are only held in m_sparseLayout.
+**********************************************************************************************************/
+bool DungeonLayout::IsSparse() const
+{
+	return m_dungeonLayout == nullptr && m_sparseLayout.GetHeight() > 0;
+}
+/**********************************************************************************************************
+*	bool IsChunked()
+*		Purpose:	Checks if the layout is made one chunk at a time. If so m_dungeonLayout is never
+*					allocated, GetDungeonLayout returns an empty view and the tiles must be read from
+*					GetChunk instead.
+*
+*		Return:		True if m_options.bChunkedGeneration is set.
+**********************************************************************************************************/
+bool DungeonLayout::IsChunked() const
+{
+	return m_options.bChunkedGeneration;
+}
+/**********************************************************************************************************
+*	void GenerateDungeonLayout()
+*		Purpose:	Generates a complete dungeon from start to finish. The finished result will be stored
+*					in the 2D array m_dungeonLayout. If a layout already exists, it will be replaced with
+*					a new one.
 *
 *		Changes:
-*			m_dungeonLayout - All tiles will be solved for.
+*			See GenerateFromStage.
 **********************************************************************************************************/
-void DungeonLayout::CreateTiles()
+void DungeonLayout::GenerateDungeonLayout()
 {
-	if (m_dungeonLayout == nullptr)
-		return;
-
-	for (int y = 0; y < m_dungeonDimensions.Y; y++)
-	{
-		for (int x = 0; x < m_dungeonDimensions.X; x++)
-		{
-			TileData solvedTile = m_dungeonLayout[y][x];
-
-			if (solvedTile.tileType != TileType::floorTile)
-			{
-				bool successfulSolve = SolveTile(x, y, solvedTile);
-
-				if (successfulSolve)
-					m_dungeonLayout[y][x] = solvedTile;
-				else
-				{
-					// Unsolvable tile error.
-				}
-			}
-		}
-	}
+	GenerateFromStage(EDungeonStage::Rooms);
 }
 /**********************************************************************************************************
-*	void GenerateRoomRecursive(QuadTreeNode * CurrentNode)
-*		Purpose:	If this node is a branch, call this function on it's children. If this node is a leaf
-*					Generate a random room for it and add it to m_rooms.
+*	void GenerateFromStage(EDungeonStage FirstStage)
+*		Purpose:	Runs the generation stages from FirstStage on, each one carrying on from the random
+*					stream where the last left it. The tree is made by the constructor, so FirstStage must
+*					come after EDungeonStage::Tree. Each stage is reported to m_progress when it is done,
+*					and if m_progress is cancelled the stages after it are not run.
 *
 *		Parameters:
-*			QuadTreeNode * CurrentNode
-*				The node to get the children of. If this is a child node, instead add a room to m_rooms
-*				and set it in this node.
+*			EDungeonStage FirstStage
+*				The first stage to run. Must be Rooms, Paths or Tiles.
 *
 *		Changes:
-*			m_rooms - A room will be added for each leaf node down the tree connected to the one passed
-*					  in.
+*			m_linearTree - Every leaf will be given a room, then rooms are dropped.
+*			m_paths - Paths will be generated between rooms and stored here.
+*			m_dungeonLayout - A new layout will be generated and stored here.
+*			m_sparseLayout - Holds the finished layout instead if m_options.bSparseTileStorage is set. The
+*				grid is still generated in full and only compacted at the end.
+*			m_chunkRects, m_chunkCache - Hold the rooms and paths of each row of chunks instead if
+*				m_options.bChunkedGeneration is set. No tiles are made until a chunk is asked for.
+*			m_floorEdits - Emptied.
+*			m_roomsStream, m_pathsStream - Hold m_randomStream as it was after each stage, so Regenerate
+*				can start again from there.
+*			m_generated - True if every stage ran.
 **********************************************************************************************************/
-void DungeonLayout::GenerateRoomRecursive(QuadTreeNode * CurrentNode)
+void DungeonLayout::GenerateFromStage(EDungeonStage FirstStage)
 {
-	if (CurrentNode != nullptr)
+	check(FirstStage != EDungeonStage::Tree && FirstStage != EDungeonStage::None);
+
+	// Edits made to the old layout do not carry over.
+	m_floorEdits.Empty();
+	m_generated = false;
+
+	if (FirstStage == EDungeonStage::Rooms)
 	{
-		QuadTreeNode ** children = CurrentNode->GetChildren();
+		GenerateRooms();
+		DropRooms();
+		m_roomsStream = m_randomStream;
 
-		// should never be nullptr but check anyway.
-		if (children != nullptr && children[0] != nullptr)
-		{
-			for (int i = 0; i < 4; i++)
-				GenerateRoomRecursive(children[i]);
-		}
-		// else this is a leaf node, create a random room for it.
-		else
-		{
-			// Create a random room and store it in this node.
-			CurrentNode->SetRoom(GenerateRandomRoom(CurrentNode->GetQuad()));
-		}
+		if (!FinishStage(EDungeonStage::Rooms))
+			return;
+	}
+
+	if (FirstStage == EDungeonStage::Rooms || FirstStage == EDungeonStage::Paths)
+	{
+		GeneratePaths();
+		m_pathsStream = m_randomStream;
+
+		if (!FinishStage(EDungeonStage::Paths))
+			return;
 	}
 
+	GenerateTiles();
+
+	if (!FinishStage(EDungeonStage::Tiles))
+		return;
+
+	m_generated = true;
 }
 /**********************************************************************************************************
-*	Quad GenerateRandomRoom(Quad MaximumBounds)
-*		Purpose:	Generates a random quad that fits inside MaximumBounds. This room has to be larger
-*					than m_minimumRoomSize.
+*	bool FinishStage(EDungeonStage Stage)
+*		Purpose:	Reports a stage as done unless generation has been cancelled. The stages are counted
+*					as equal steps, so after Stage the progress is the number of stages up to and
+*					including it over the number of stages.
 *
 *		Parameters:
-*			Quad MaximumBounds
-*				The Quad generated will fit inside this, respecting position as well as bounds.
+*			EDungeonStage Stage
+*				The stage that was just run.
 *
-*		Return:		Returns a Quad that is at least as big as the minimum and fits inside the given space.
+*		Return:		False if m_progress has been cancelled and generation should stop.
 **********************************************************************************************************/
-Quad DungeonLayout::GenerateRandomRoom(Quad MaximumBounds)
+bool DungeonLayout::FinishStage(EDungeonStage Stage)
 {
-	FVector TopRight = MaximumBounds.GetBounds();
-	FVector BottomLeft = MaximumBounds.GetPosition();
+	if (m_progress == nullptr)
+		return true;
 
-	FVector BottomLeftMin = FVector(0, 0, 0);
-	FVector BottomLeftMax = FVector(0, 0, 0);
-	FVector TopRightMin = FVector(0, 0, 0);
-	FVector TopRightMax = FVector(0, 0, 0);
+	// A cancelled stage may have stopped part way, so it is not counted.
+	if (m_progress->IsCancelled())
+		return false;
 
-	// The closest position the bottom left corner can be to the bottom left corner of the quad and still
-	// generate a room of minimumSize.
-	BottomLeftMin = BottomLeft;
+	m_progress->SetProgress((float)((int)Stage + 1) / (int)EDungeonStage::None);
+
+	return true;
+}
+/**********************************************************************************************************
+*	bool IsCancelled()
+*		Purpose:	Checks if generation has been asked to stop.
+*
+*		Return:		True if m_progress is set and has been cancelled.
+**********************************************************************************************************/
+bool DungeonLayout::IsCancelled() const
+{
+	return m_progress != nullptr && m_progress->IsCancelled();
+}
+/**********************************************************************************************************
+*	EDungeonStage Regenerate(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth,
+*							 int ErosionPasses, float ErosionChance, FRandomStream RNG,
+*							 FDungeonGenerationOptions Options, DungeonGenerationProgress * Progress)
+*		Purpose:	Brings the layout up to date with a new set of parameters, re-running only the stages
+*					that depend on a parameter that changed. The result is the same as constructing a new
+*					layout with the parameters. The stages and what they depend on are:
+*
+*					Tree	- The size of the dungeon and rooms, the depth DesiredRooms needs, the random
+*							  stream and bSplitRandomStreams. Rebuilds everything.
+*					Rooms	- DesiredRooms and RoomDropMode. Makes every leaf's room again starting from
+*							  the random stream given, then drops rooms.
+*					Paths	- PathWidth, bNearestRoomSearch and bParallelPathGeneration. Starts from the
+*							  stream as it was after the rooms.
+*					Tiles	- The erosion parameters and the storage options. Starts from the stream as it
+*							  was after the paths and fills, erodes and solves the tiles again.
+*
+*					TileSolveMode and bParallelTileSolve give the same tiles, so changing only them does
+*					not re-run anything.
+*
+*					If Progress is cancelled the layout is left part way and the next call rebuilds it
+*					from the tree. Callers that need to keep the last completed layout, such as
+*					AProceduralDungeon::GenerateTilesAsync, regenerate a copy of it instead.
+*
+*		Parameters:
+*			The same as the constructor.
+*
+*		Changes:
+*			Everything a stage that is re-run makes. Pending edits are dropped if any stage is re-run.
+*
+*		Return:		The first stage that was re-run, EDungeonStage::None if nothing changed.
+**********************************************************************************************************/
+EDungeonStage DungeonLayout::Regenerate(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth, int ErosionPasses, float ErosionChance, FRandomStream RNG, FDungeonGenerationOptions Options, DungeonGenerationProgress * Progress)
+{
+	EDungeonStage stage = EDungeonStage::None;
+
+	if (!m_generated || !CanGenerate(DungeonSize, PathWidth) || DungeonSize != m_dungeonDimensions || MinimumRoomSize != m_minimumRoomSize
+		|| GetTreeDepth(DesiredRooms) != GetTreeDepth(m_targetNumRooms) || RNG.GetInitialSeed() != m_initialStream.GetInitialSeed()
+		|| RNG.GetCurrentSeed() != m_initialStream.GetCurrentSeed() || Options.bSplitRandomStreams != m_options.bSplitRandomStreams)
+		stage = EDungeonStage::Tree;
+	else if (DesiredRooms != m_targetNumRooms || Options.RoomDropMode != m_options.RoomDropMode)
+		stage = EDungeonStage::Rooms;
+	else if (PathWidth != m_pathWidth || Options.bNearestRoomSearch != m_options.bNearestRoomSearch
+		|| Options.bParallelPathGeneration != m_options.bParallelPathGeneration)
+		stage = EDungeonStage::Paths;
+	else if (ErosionPasses != m_erosionPasses || ErosionChance != m_erosionChance || Options.ErosionMode != m_options.ErosionMode
+		|| Options.bSparseTileStorage != m_options.bSparseTileStorage || Options.bChunkedGeneration != m_options.bChunkedGeneration
+		|| (Options.bChunkedGeneration && (Options.ChunkSize != m_options.ChunkSize || Options.ChunkCacheMegabytes != m_options.ChunkCacheMegabytes)))
+		stage = EDungeonStage::Tiles;
+
+	if (stage == EDungeonStage::Tree)
+	{
+		*this = DungeonLayout(DungeonSize, MinimumRoomSize, DesiredRooms, PathWidth, ErosionPasses, ErosionChance, RNG, Options, Progress);
+		return stage;
+	}
+
+	m_targetNumRooms = DesiredRooms;
+	m_pathWidth = PathWidth;
+	m_erosionPasses = ErosionPasses;
+	m_erosionChance = ErosionChance;
+	m_options = Options;
+
+	m_progress = Progress;
+
+	if (stage == EDungeonStage::None)
+	{
+		FinishStage(EDungeonStage::Tiles);
+		m_progress = nullptr;
+		return stage;
+	}
+
+	// Start from the stream as it was before the first stage to run.
+	if (stage == EDungeonStage::Rooms)
+		m_randomStream = m_initialStream;
+	else if (stage == EDungeonStage::Paths)
+		m_randomStream = m_roomsStream;
+	else
+		m_randomStream = m_pathsStream;
+
+	GenerateFromStage(stage);
+
+	m_progress = nullptr;
+
+	return stage;
+}
+/**********************************************************************************************************
+*	void GenerateTiles()
+*		Purpose:	Runs the generation steps after the paths. The rooms and paths are filled in, eroded
+*					and solved, or filed for chunks if the layout is chunked.
+*
+*		Changes:
+*			m_dungeonLayout - A new layout will be generated and stored here.
+*			m_sparseLayout - Holds the finished layout instead if m_options.bSparseTileStorage is set. The
+*				grid is still generated in full and only compacted at the end.
+*			m_chunkRects, m_chunkCache - Hold the rooms and paths of each row of chunks instead if
+*				m_options.bChunkedGeneration is set.
+**********************************************************************************************************/
+void DungeonLayout::GenerateTiles()
+{
+	// A compacted layout needs its grid back to be generated again, and the storage options may have
+	// changed since the grid was made.
+	m_sparseLayout.Empty();
+
+	if ((m_dungeonLayout == nullptr) != m_options.bChunkedGeneration || m_layoutWidth == 0)
+		AllocateDungeonLayout();
+
+	if (m_options.bChunkedGeneration)
+	{
+		PrepareChunks();
+		return;
+	}
+
+	// Chunks left over from before the options changed.
+	m_chunkRects.Empty();
+	m_chunkRowFirstRect.Empty();
+	m_chunkCache.Empty();
+
+	// The tile steps are the slowest, so a cancel is also checked between them.
+	CreateRoomLayout();
+
+	if (IsCancelled())
+		return;
+
+	ErodeRoomLayout();
+
+	if (IsCancelled())
+		return;
+
+	CreateTiles();
+
+	if (m_options.bSparseTileStorage)
+		CompactDungeonLayout();
+}
+/**********************************************************************************************************
+*	bool SetFloor(int X, int Y, bool Floor)
+*		Purpose:	Queues an edit making one tile a floor or taking its floor away. See SetFloorRect.
+*
+*		Parameters:
+*			int X, int Y
+*				The tile to edit.
+*			bool Floor
+*				True to make the tile a floor, false to make it a wall or empty, whichever its
+*				neighbors solve it to.
+*
+*		Return:		True if the edit was queued.
+**********************************************************************************************************/
+bool DungeonLayout::SetFloor(int X, int Y, bool Floor)
+{
+	return SetFloorRect(TileRect(X, Y, X + 1, Y + 1), Floor);
+}
+/**********************************************************************************************************
+*	bool SetFloorRect(TileRect Rect, bool Floor)
+*		Purpose:	Queues an edit making every tile in a rectangle a floor or taking their floors away.
+*					Nothing in the layout changes until ResolveDirtyTiles, so many edits can be made and
+*					the tiles they touch solved once.
+*
+*		Parameters:
+*			TileRect Rect
+*				The tiles to edit. Cut down to fit inside the layout.
+*			bool Floor
+*				True to make the tiles floors, false to make them walls or empties, whichever their
+*				neighbors solve them to.
+*
+*		Changes:
+*			m_floorEdits - The edit is added.
+*
+*		Return:		True if the edit was queued. Sparse and chunked layouts have no grid to edit, and an
+*					edit with no tiles inside the layout is dropped.
+**********************************************************************************************************/
+bool DungeonLayout::SetFloorRect(TileRect Rect, bool Floor)
+{
+	if (m_dungeonLayout == nullptr)
+		return false;
+
+	Rect = Rect.Intersect(TileRect(0, 0, m_layoutWidth, m_layoutHeight));
+
+	if (Rect.IsEmpty())
+		return false;
+
+	FloorEdit edit;
+	edit.rect = Rect;
+	edit.bFloor = Floor;
+
+	m_floorEdits.Add(edit);
+
+	return true;
+}
+/**********************************************************************************************************
+*	bool HasDirtyTiles()
+*		Purpose:	Checks if there are edits waiting for ResolveDirtyTiles.
+*
+*		Return:		True if any edits are queued.
+**********************************************************************************************************/
+bool DungeonLayout::HasDirtyTiles() const
+{
+	return m_floorEdits.Num() > 0;
+}
+/**********************************************************************************************************
+*	void ResolveDirtyTiles(TArray<TileChange> & ChangedTiles)
+*		Purpose:	Applies the queued edits and solves only the tiles they can affect. A tile is solved
+*					from the floors in its 3x3 neighborhood, so the dirty region of an edit is its
+*					rectangle grown by one tile. The work done follows the edited area rather than the
+*					size of the map.
+*
+*					The dirty tiles are copied before anything is changed. The edits are then applied in
+*					the order they were made, every dirty tile is solved again with SolveTile and compared
+*					against its copy. Dirty regions can overlap, so the changes are sorted by position and
+*					each tile is reported once. Edits are not eroded and are not added to m_floorSpans.
+*
+*		Parameters:
+*			TArray<TileChange> & ChangedTiles
+*				Replaced with every tile whose type or rotation changed, in row order.
+*
+*		Changes:
+*			m_dungeonLayout - The edits are applied and the tiles around them solved again.
+*			m_floorEdits - Emptied.
+**********************************************************************************************************/
+void DungeonLayout::ResolveDirtyTiles(TArray<TileChange> & ChangedTiles)
+{
+	ChangedTiles.Reset();
+
+	if (m_dungeonLayout == nullptr)
+	{
+		m_floorEdits.Empty();
+		return;
+	}
+
+	TileRect layoutBounds = TileRect(0, 0, m_layoutWidth, m_layoutHeight);
+
+	// Copy every dirty tile before the first edit is applied.
+	TArray<TileRect> dirtyRects;
+	TArray<TileData> oldTiles;
+	dirtyRects.Reserve(m_floorEdits.Num());
+
+	for (int i = 0; i < m_floorEdits.Num(); i++)
+	{
+		const TileRect & rect = m_floorEdits[i].rect;
+		TileRect dirty = TileRect(rect.xStart - 1, rect.yStart - 1, rect.xEnd + 1, rect.yEnd + 1).Intersect(layoutBounds);
+
+		dirtyRects.Add(dirty);
+
+		for (int y = dirty.yStart; y < dirty.yEnd; y++)
+			oldTiles.Append(m_dungeonLayout + y * m_layoutWidth + dirty.xStart, dirty.xEnd - dirty.xStart);
+	}
+
+	// Apply the edits. A tile losing its floor is solved below along with the rest.
+	for (int i = 0; i < m_floorEdits.Num(); i++)
+	{
+		const FloorEdit & edit = m_floorEdits[i];
+		TileData newTile = TileData(edit.bFloor ? floorTile : emptyTile);
+
+		for (int y = edit.rect.yStart; y < edit.rect.yEnd; y++)
+			FMemory::Memset(m_dungeonLayout + y * m_layoutWidth + edit.rect.xStart, newTile.packedTile, edit.rect.xEnd - edit.rect.xStart);
+	}
+
+	m_floorEdits.Empty();
+
+	// Solve the dirty tiles. Solving only reads which neighbors are floors, and the floors are all
+	// final now, so a tile in more than one dirty region solves the same each time.
+	for (int i = 0; i < dirtyRects.Num(); i++)
+	{
+		const TileRect & dirty = dirtyRects[i];
+
+		for (int y = dirty.yStart; y < dirty.yEnd; y++)
+		{
+			TileData * row = m_dungeonLayout + y * m_layoutWidth;
+
+			for (int x = dirty.xStart; x < dirty.xEnd; x++)
+			{
+				TileData solvedTile = row[x];
+
+				if (SolveTile(x, y, solvedTile))
+					row[x] = solvedTile;
+			}
+		}
+	}
+
+	// Report each tile that ended up different from its copy.
+	int oldTile = 0;
+
+	for (int i = 0; i < dirtyRects.Num(); i++)
+	{
+		const TileRect & dirty = dirtyRects[i];
+
+		for (int y = dirty.yStart; y < dirty.yEnd; y++)
+		{
+			for (int x = dirty.xStart; x < dirty.xEnd; x++, oldTile++)
+			{
+				if (m_dungeonLayout[y * m_layoutWidth + x] != oldTiles[oldTile])
+					ChangedTiles.Add(TileChange(x, y, oldTiles[oldTile], m_dungeonLayout[y * m_layoutWidth + x]));
+			}
+		}
+	}
+
+	if (dirtyRects.Num() > 1)
+	{
+		ChangedTiles.Sort([](const TileChange & A, const TileChange & B)
+		{
+			return A.y < B.y || (A.y == B.y && A.x < B.x);
+		});
+
+		// Every copy of a tile was taken before any edit, so duplicates are identical.
+		int kept = 0;
+
+		for (int i = 0; i < ChangedTiles.Num(); i++)
+		{
+			if (kept == 0 || ChangedTiles[kept - 1].x != ChangedTiles[i].x || ChangedTiles[kept - 1].y != ChangedTiles[i].y)
+				ChangedTiles[kept++] = ChangedTiles[i];
+		}
+
+		ChangedTiles.SetNum(kept);
+	}
+}
+/**********************************************************************************************************
+*	void GenerateRooms()
+*		Purpose:	Gives each leaf of m_linearTree a random sized room that fits in its quad. This
+*					room will be no smaller than m_minimumRoomSize including walls. A room will be
+*					generated for every quad regardless of if it is used in the final layout or not.
+*
+*					The leaves are walked in depth first order, the same order the tree was built in. If
+*					m_options.bSplitRandomStreams is set each leaf makes its room from its own stream
+*					instead of m_randomStream. No two leaves share anything then, so all leaves are done
+*					in parallel and the rooms come out the same in any order.
+*
+*		Changes:
+*			m_linearTree - Every leaf will be given a room and the cached room bounds are refreshed.
+**********************************************************************************************************/
+void DungeonLayout::GenerateRooms()
+{
+	if (m_options.bSplitRandomStreams)
+	{
+		ParallelFor(m_linearTree.NumLeaves(), [this](int32 Leaf)
+		{
+			LinearQuadTreeNode & leaf = m_linearTree.GetLeaf(Leaf);
+
+			// A leaf never slices, so its own stream has not been drawn from yet.
+			FRandomStream roomStream = leaf.stream;
+			leaf.room = GenerateRandomRoom(leaf.quad, roomStream);
+		});
+	}
+	else
+	{
+		for (int i = 0; i < m_linearTree.NumLeaves(); i++)
+		{
+			LinearQuadTreeNode & leaf = m_linearTree.GetLeaf(i);
+			leaf.room = GenerateRandomRoom(leaf.quad, m_randomStream);
+		}
+	}
+
+	m_linearTree.RefreshRoomBounds();
+}
+/**********************************************************************************************************
+*	void DropRooms()
+*		Purpose:	Picks random rooms and removes them from the list of rooms until m_targetNumberRooms
+*					is reached. If m_targetNumberRooms is larger than the number of existing rooms, no
+*					action is performed. m_options.RoomDropMode picks how the rooms are chosen.
+*
+*		Changes:
+*			m_linearTree - Dropped rooms are removed from their leaves.
+**********************************************************************************************************/
+void DungeonLayout::DropRooms()
+{
+	if (m_options.RoomDropMode == ERoomDropMode::Shuffle)
+	{
+		DropRoomsShuffle();
+		return;
+	}
+
+	int roomCount = CountRooms();
+
+	// A drop can land on a leaf that was already dropped. The original generator still counted it, so
+	// the count is not read back from the tree after each drop.
+	while (roomCount > m_targetNumRooms)
+	{
+		DropRandomRoom();
+		roomCount--;
+	}
+}
+/**********************************************************************************************************
+*	void DropRoomsShuffle()
+*		Purpose:	DropRooms for ERoomDropMode::Shuffle. Lists the leaves that have a room and runs the
+*					first k steps of a Fisher-Yates shuffle on the list with m_randomStream, where k is
+*					the number of rooms over m_targetNumRooms. Step i swaps a random entry from i to the
+*					end into slot i, so the first k entries end up as a uniformly random set of k rooms,
+*					which are dropped. The cached room bounds are refreshed once at the end, so the whole
+*					drop is linear in the number of leaves however many rooms are dropped.
+*
+*		Changes:
+*			m_linearTree - Exactly enough rooms are removed from their leaves to reach m_targetNumRooms.
+**********************************************************************************************************/
+void DungeonLayout::DropRoomsShuffle()
+{
+	int roomCount = CountRooms();
+
+	if (roomCount <= m_targetNumRooms)
+		return;
+
+	TArray<int> liveLeaves;
+	liveLeaves.Reserve(roomCount);
+
+	for (int i = 0; i < m_linearTree.NumLeaves(); i++)
+	{
+		if (m_linearTree.GetLeaf(i).HasRoom())
+			liveLeaves.Add(i);
+	}
+
+	int dropCount = roomCount - FMath::Max(m_targetNumRooms, 0);
+
+	for (int i = 0; i < dropCount; i++)
+	{
+		liveLeaves.Swap(i, m_randomStream.RandRange(i, roomCount - 1));
+		m_linearTree.GetLeaf(liveLeaves[i]).room = Quad();
+	}
+
+	m_linearTree.RefreshRoomBounds();
+}
+/**********************************************************************************************************
+*	void GeneratePaths()
+*		Purpose:	Connects the rooms under each branch of m_linearTree with paths, drawing from
+*					m_randomStream. If m_options.bParallelPathGeneration is set GeneratePathsParallel is
+*					used instead.
+*
+*		Changes:
+*			m_paths - Replaced with the paths between rooms.
+**********************************************************************************************************/
+void DungeonLayout::GeneratePaths()
+{
+	m_paths.Empty();
+
+	if (m_options.bParallelPathGeneration)
+	{
+		GeneratePathsParallel();
+		return;
+	}
+
+	// Nodes are stored depth first, so this visits the branches in the same order as walking down
+	// the tree would.
+	for (int i = 0; i < m_linearTree.Num(); i++)
+	{
+		if (!m_linearTree.GetNode(i).IsLeaf())
+			GeneratePathsForNode(i, m_randomStream, m_paths);
+	}
+}
+/**********************************************************************************************************
+*	void GeneratePathsParallel()
+*		Purpose:	Parallel version of GeneratePaths. Each branch only reads the rooms and quads under it
+*					and, with a stream of its own from DungeonRandom::DeriveNodeStream, shares nothing
+*					with any other branch. The branches are split into batches of m_PATH_BATCH_NODES in
+*					depth first order, so a batch is mostly whole subtrees, and each batch is a
+*					ParallelFor task writing to its own list of paths. The lists are joined in batch
+*					order afterwards, giving the same paths in the same order however the tasks are
+*					scheduled.
+*
+*		Changes:
+*			m_paths - Replaced with the paths between rooms.
+**********************************************************************************************************/
+void DungeonLayout::GeneratePathsParallel()
+{
+	TArray<int> branches;
+	branches.Reserve(m_linearTree.Num() - m_linearTree.NumLeaves());
+
+	for (int i = 0; i < m_linearTree.Num(); i++)
+	{
+		if (!m_linearTree.GetNode(i).IsLeaf())
+			branches.Add(i);
+	}
+
+	int batchCount = (branches.Num() + m_PATH_BATCH_NODES - 1) / m_PATH_BATCH_NODES;
+	int seed = m_seed;
+
+	TArray<TArray<Quad>> batchPaths;
+	batchPaths.SetNum(batchCount);
+
+	ParallelFor(batchCount, [this, &branches, &batchPaths, seed](int32 Batch)
+	{
+		int firstBranch = Batch * m_PATH_BATCH_NODES;
+		int lastBranch = FMath::Min(firstBranch + m_PATH_BATCH_NODES, branches.Num());
+
+		for (int i = firstBranch; i < lastBranch; i++)
+		{
+			const LinearQuadTreeNode & node = m_linearTree.GetNode(branches[i]);
+			FRandomStream stream = DungeonRandom::DeriveNodeStream(seed, node.level, node.mortonCode);
+
+			GeneratePathsForNode(branches[i], stream, batchPaths[Batch]);
+		}
+	});
+
+	int pathCount = 0;
+
+	for (int i = 0; i < batchCount; i++)
+		pathCount += batchPaths[i].Num();
+
+	m_paths.Reserve(pathCount);
+
+	for (int i = 0; i < batchCount; i++)
+		m_paths.Append(batchPaths[i]);
+}
+/**********************************************************************************************************
+*	void CreateRoomLayout()
+*		Purpose:	Passes through each room and path in m_rooms and m_paths and assigns them as a floor
+*					in m_dungeonLayout. For example, If a room includes the point (33,44) the tile at
+*					(33,44) will be set to floor. All other tiles not in a room
+*					or path are set to empty.
+*
+*					The original fill drew a random rotation for every floor tile and never used it. The
+*					tiles are now filled a row at a time without drawing, and m_randomStream is skipped
+*					past the numbers that used to be drawn so the later steps still draw the same ones.
+*
+*		Changes:
+*			m_dungeonLayout - The values are changed depending on if a room or path overlaps with the
+*				array location.
+*			m_floorSpans - Replaced with the spans of every room and path.
+*			m_randomStream - Skipped ahead one number per floor tile filled.
+**********************************************************************************************************/
+void DungeonLayout::CreateRoomLayout()
+{
+	ClearDungeonLayout();
+	m_floorSpans.Reset();
+
+	uint64 tilesFilled = 0;
+
+	ForEachRoom([this, &tilesFilled](const Quad & Room)
+	{
+		tilesFilled += CreateFloorQuad(Room);
+	});
+
+	for (int i = 0; i < m_paths.Num(); i++)
+		tilesFilled += CreateFloorQuad(m_paths[i]);
+
+	m_randomStream = FRandomStream(DungeonRandom::AdvanceSeed(m_randomStream.GetCurrentSeed(), tilesFilled));
+}
+/**********************************************************************************************************
+*	void ErodeRoomLayout()
+*		Purpose:	Causes each empty adjacent to a floor tile to have a chance to be replaced with a
+*					floor tile. The process is then repeated for erosion passes times. This allows semi
+*					random looking rooms to look natural.
+*
+*					The original scan drew a number for every tile off the edge of the layout, but a tile
+*					with no floor next to it can never erode. The range of floors in each row is kept, so
+*					only the tiles that can touch a floor are visited, and m_randomStream is jumped over
+*					the numbers the rest would have drawn. The result is the same as the full scan while
+*					the time follows the built area rather than the size of the map.
+*		Changes:
+*			m_dungeonLayout - The values of tiles touching floor tiles have a chance to become floor tiles.
+**********************************************************************************************************/
+void DungeonLayout::ErodeRoomLayout()
+{
+	// If no erosion to be done.
+	if (m_erosionPasses == 0 || m_erosionChance == 0 || m_dungeonLayout == nullptr)
+		return;
+
+	if (m_options.ErosionMode == EErosionMode::Bitboard)
+	{
+		ErodeRoomLayoutBitboard();
+		return;
+	}
+
+	if (m_options.ErosionMode == EErosionMode::Hashed)
+	{
+		ErodeRoomLayoutHashed();
+		return;
+	}
+
+	// Tiles on the edge of the layout are never eroded and never draw a number.
+	if (m_layoutWidth < 3 || m_layoutHeight < 3)
+		return;
+
+	// The range of X holding floors in each row. The floors so far are exactly the spans of the
+	// rooms and paths.
+	TArray<int> floorStart;
+	TArray<int> floorEnd;
+	floorStart.Init(m_layoutWidth, m_layoutHeight);
+	floorEnd.Init(0, m_layoutHeight);
+
+	for (int i = 0; i < m_floorSpans.Num(); i++)
+	{
+		const TileSpan & span = m_floorSpans[i];
+
+		floorStart[span.y] = FMath::Min(floorStart[span.y], span.xStart);
+		floorEnd[span.y] = FMath::Max(floorEnd[span.y], span.xEnd);
+	}
+
+	// Every tile off the edge draws one number per pass, in row order. drawsTaken is how many of those
+	// numbers have been drawn or jumped over so far.
+	int innerWidth = m_layoutWidth - 2;
+	uint64 drawsPerPass = (uint64)innerWidth * (m_layoutHeight - 2);
+	uint64 drawsTaken = 0;
+
+	for (int pass = 0; pass < m_erosionPasses; pass++)
+	{
+		for (int y = 1; y < m_layoutHeight - 1; y++)
+		{
+			TileData * row = m_dungeonLayout + y * m_layoutWidth;
+
+			// Only tiles next to a floor in this row or the rows above and below can touch one.
+			int firstX = FMath::Max(FMath::Min3(floorStart[y - 1], floorStart[y] - 1, floorStart[y + 1]), 1);
+			int endX = FMath::Min(FMath::Max3(floorEnd[y - 1], floorEnd[y] + 1, floorEnd[y + 1]), m_layoutWidth - 1);
+
+			for (int x = firstX; x < endX; x++)
+			{
+				int adjacentFloorTiles = 0;
+
+				// Check adjacent tiles for floor tile count
+				if (row[x - m_layoutWidth].GetTileType() == floorTile)
+					adjacentFloorTiles++;
+				if (row[x - 1].GetTileType() == floorTile)
+					adjacentFloorTiles++;
+				if (row[x + 1].GetTileType() == floorTile)
+					adjacentFloorTiles++;
+				if (row[x + m_layoutWidth].GetTileType() == floorTile)
+					adjacentFloorTiles++;
+
+				// Jump over the numbers the skipped tiles would have drawn.
+				uint64 draw = pass * drawsPerPass + (uint64)(y - 1) * innerWidth + (x - 1);
+
+				if (draw != drawsTaken)
+					m_randomStream = FRandomStream(DungeonRandom::AdvanceSeed(m_randomStream.GetCurrentSeed(), draw - drawsTaken));
+
+				drawsTaken = draw + 1;
+
+				// The more floor tiles the tile is touching, the more likely it is to be
+				// eroded. This will cause a more rounder look.
+				if (m_randomStream.FRand() * 100 < m_erosionChance * adjacentFloorTiles)
+				{
+					row[x] = TileData(floorTile);
+
+					floorStart[y] = FMath::Min(floorStart[y], x);
+					floorEnd[y] = FMath::Max(floorEnd[y], x + 1);
+
+					// The next tile now touches a floor even if it was past the range.
+					endX = FMath::Max(endX, FMath::Min(x + 2, m_layoutWidth - 1));
+				}
+			}
+		}
+	}
+
+	uint64 totalDraws = m_erosionPasses * drawsPerPass;
+
+	if (drawsTaken != totalDraws)
+		m_randomStream = FRandomStream(DungeonRandom::AdvanceSeed(m_randomStream.GetCurrentSeed(), totalDraws - drawsTaken));
+}
+/**********************************************************************************************************
+*	void ErodeRoomLayoutBitboard()
+*		Purpose:	Bitboard version of ErodeRoomLayout. The floors are packed into a FloorBitboard and the
+*					orthogonal floor neighbors of 64 tiles are counted at once with shifts and a bit sliced
+*					adder. Only tiles with at least one floor neighbor draw a random number. Each pass reads
+*					the board left by the previous pass and writes a new one row by row, so unlike the
+*					sequential version a tile eroded this pass does not affect its neighbors until the next.
+*
+*		Changes:
+*			m_dungeonLayout - The values of tiles touching floor tiles have a chance to become floor tiles.
+**********************************************************************************************************/
+void DungeonLayout::ErodeRoomLayoutBitboard()
+{
+	FloorBitboard initialFloors = FloorBitboard(GetDungeonLayout());
+	FloorBitboard currentFloors = initialFloors;
+	FloorBitboard nextFloors = initialFloors;
+
+	int wordsPerRow = currentFloors.GetWordsPerRow();
+	int lastColumn = m_layoutWidth - 1;
 
-	// The closest position the bottom left corner can be to the top right corner and  still generate a
-	// room of at least minimumSize.
-	BottomLeftMax = TopRight - m_minimumRoomSize;
+	for (int pass = 0; pass < m_erosionPasses; pass++)
+	{
+		// edges cannot be eroded so the first and last rows are skipped.
+		for (int y = 1; y < m_layoutHeight - 1; y++)
+		{
+			const uint64 * floors = currentFloors.GetRow(y);
+			uint64 * erodedFloors = nextFloors.GetRow(y);
 
-	// Pick a random bottom left corner.
-	FVector newRoomPosition = FVector(0, 0, 0);
-	newRoomPosition.X = m_randomStream.RandRange(BottomLeftMin.X, BottomLeftMax.X);
-	newRoomPosition.Y = m_randomStream.RandRange(BottomLeftMin.Y, BottomLeftMax.Y);
+			for (int word = 0; word < wordsPerRow; word++)
+			{
+				// Count the floors next to every tile at once. Afterwards the floor count of a tile is
+				// ones + 2 * twos + 4 * fours at its bit.
+				uint64 ones, twos, fours;
+				uint64 neighbors = currentFloors.CountOrthogonalNeighbors(y, word, ones, twos, fours);
 
-	// The closest position the top right corner can be to the bottom left of the quad and still
-	// generate a room of minimumSize.
-	TopRightMin = newRoomPosition + m_minimumRoomSize;
+				// The first and last column are edges as well.
+				uint64 interior = currentFloors.GetValidBits(word);
 
-	// The closest position the top right corner can be to the top right corner of the quad and still
-	// generate a room of minimumSize.
-	TopRightMax = TopRight;
+				if (word == 0)
+					interior &= ~(uint64)1;
+				if (word == lastColumn >> 6)
+					interior &= ~((uint64)1 << (lastColumn & 63));
 
-	// Pick a random top right corner.
-	FVector newRoomBounds = FVector(0, 0, 0);
-	newRoomBounds.X = m_randomStream.RandRange((int)TopRightMin.X, (int)TopRightMax.X);
-	newRoomBounds.Y = m_randomStream.RandRange((int)TopRightMin.Y, (int)TopRightMax.Y);
+				// Only walls touching a floor can erode.
+				uint64 candidates = neighbors & ~floors[word] & interior;
 
-	return Quad(newRoomBounds, newRoomPosition);
+				while (candidates != 0)
+				{
+					int bit = FloorBitboard::CountTrailingZeros(candidates);
+					candidates &= candidates - 1;
+
+					int adjacentFloorTiles = (int)((ones >> bit) & 1) + 2 * (int)((twos >> bit) & 1) + 4 * (int)((fours >> bit) & 1);
+
+					// The more floor tiles the tile is touching, the more likely it is to be
+					// eroded. This will cause a more rounder look.
+					if (m_randomStream.FRand() * 100 < m_erosionChance * adjacentFloorTiles)
+						erodedFloors[word] |= (uint64)1 << bit;
+				}
+			}
+		}
+
+		currentFloors = nextFloors;
+	}
+
+	WriteErodedFloors(initialFloors, currentFloors);
 }
 /**********************************************************************************************************
-*	bool DropRandomRoomRecursive(QuadTreeNode * CurrentNode)
-*		Purpose:	Traverses the tree from CurrentNode down looking for leaf nodes. When a leaf node is
-*					found, Its room will attempt to be deleted. If this fails (the room doesn't exist),
-*					another sibling leaf node will be attempted, If failure continues, the function will
-*					proceed up the tree trying all leaf nodes in a random order until CurrentNode is hit
-*					again. At this point, this function will return false.
+*	void ErodeRoomLayoutHashed()
+*		Purpose:	Hashed version of ErodeRoomLayout. Packs the floors into a FloorBitboard, erodes the
+*					whole board with ErodeFloorsHashed and writes the new floors back. Does not draw from
+*					m_randomStream.
 *
-*		Parameters:
-*			QuadTreeNode * CurrentNode
-*					The highest node in the tree to remove rooms from.
-*		
 *		Changes:
-*			m_rooms - A random room will be removed from m_rooms unless empty.
+*			m_dungeonLayout - The values of tiles touching floor tiles have a chance to become floor tiles.
+**********************************************************************************************************/
+void DungeonLayout::ErodeRoomLayoutHashed()
+{
+	FloorBitboard initialFloors = FloorBitboard(GetDungeonLayout());
+	FloorBitboard erodedFloors = initialFloors;
+
+	ErodeFloorsHashed(erodedFloors, 0, 0);
+
+	WriteErodedFloors(initialFloors, erodedFloors);
+}
+/**********************************************************************************************************
+*	void ErodeFloorsHashed(FloorBitboard & Floors, int OriginX, int OriginY)
+*		Purpose:	Erodes the floors of a window of the layout. Works like ErodeRoomLayoutBitboard, except
+*					the random number for a tile comes from DungeonRandom::HashTile with the dungeon seed
+*					m_seed, the pass and the tile's layout position. Each pass reads one board and
+*					writes the other, so no tile sees another tile's result until the next pass and bands of
+*					rows are eroded in parallel with the same result as eroding them in order.
+*
+*					Floors outside the window are unknown and treated as walls. A wrong answer at the edge
+*					of the window moves one tile inward per pass, so to reproduce a region exactly it has to
+*					be eroded with a halo of m_erosionPasses tiles around it. Edges of the layout itself are
+*					never eroded, the same as the other modes.
 *
-*		Return:		Returns true if a leaf node belonging to this tree had a room removed. false if not.
+*		Parameters:
+*			FloorBitboard & Floors
+*				The floors of the window before erosion. Must fit inside the layout when placed at the
+*				origin.
+*			int OriginX, int OriginY
+*				The layout position of the tile at (0, 0) in Floors.
+*
+*		Changes:
+*			Floors - The tiles touching floor tiles have a chance to become floor tiles.
 **********************************************************************************************************/
-bool DungeonLayout::DropRandomRoomRecursive(QuadTreeNode * CurrentNode)
+void DungeonLayout::ErodeFloorsHashed(FloorBitboard & Floors, int OriginX, int OriginY) const
 {
-	if (CurrentNode != nullptr)
-	{
-		QuadTreeNode ** children = CurrentNode->GetChildren();
+	check(OriginX >= 0 && OriginY >= 0);
+	check(OriginX + Floors.GetWidth() <= m_layoutWidth && OriginY + Floors.GetHeight() <= m_layoutHeight);
 
-		// Short circuit evaluation of "If the current node has children."
-		if (children != nullptr && children[0] != nullptr)
-		{
-			int failedTries = 0;
-			int failedChildren[4] = { -1, -1, -1, -1 };
+	if (m_erosionPasses == 0 || m_erosionChance == 0)
+		return;
+
+	int seed = m_seed;
+	int height = Floors.GetHeight();
+	int wordsPerRow = Floors.GetWordsPerRow();
+	int bandCount = (height + m_EROSION_BAND_ROWS - 1) / m_EROSION_BAND_ROWS;
 
-			bool removedARoom = false;
-			bool childHasFailed = false;
-			int randomChild = 0;
+	// Where the edges of the layout fall in the window. They are outside the window if the window
+	// does not touch that edge.
+	int westEdge = -OriginX;
+	int eastEdge = m_layoutWidth - 1 - OriginX;
+	int southEdge = -OriginY;
+	int northEdge = m_layoutHeight - 1 - OriginY;
+
+	FloorBitboard nextFloors = Floors;
+
+	for (int pass = 0; pass < m_erosionPasses; pass++)
+	{
+		ParallelFor(bandCount, [&](int32 Band)
+		{
+			int firstRow = Band * m_EROSION_BAND_ROWS;
+			int lastRow = FMath::Min(firstRow + m_EROSION_BAND_ROWS, height);
 
-			// While there are still children that have not failed.
-			while (removedARoom == false && failedTries < 4)
+			for (int y = firstRow; y < lastRow; y++)
 			{
-				randomChild = m_randomStream.RandRange(0, 3);
-				childHasFailed = false;
+				const uint64 * floors = Floors.GetRow(y);
+				uint64 * erodedFloors = nextFloors.GetRow(y);
 
-				// make sure the random child has not already been tried.
-				for (int i = 0; i < failedTries; i++)
+				for (int word = 0; word < wordsPerRow; word++)
 				{
-					if (randomChild == failedChildren[i])
-						childHasFailed = true;
+					erodedFloors[word] = floors[word];
+
+					if (y == southEdge || y == northEdge)
+						continue;
+
+					// Count the floors next to every tile at once. Afterwards the floor count of a tile is
+					// ones + 2 * twos + 4 * fours at its bit.
+					uint64 ones, twos, fours;
+					uint64 neighbors = Floors.CountOrthogonalNeighbors(y, word, ones, twos, fours);
+
+					uint64 interior = Floors.GetValidBits(word);
+
+					if (westEdge >= 0 && word == westEdge >> 6)
+						interior &= ~((uint64)1 << (westEdge & 63));
+					if (eastEdge < Floors.GetWidth() && word == eastEdge >> 6)
+						interior &= ~((uint64)1 << (eastEdge & 63));
+
+					// Only walls touching a floor can erode.
+					uint64 candidates = neighbors & ~floors[word] & interior;
+
+					while (candidates != 0)
+					{
+						int bit = FloorBitboard::CountTrailingZeros(candidates);
+						candidates &= candidates - 1;
+
+						int adjacentFloorTiles = (int)((ones >> bit) & 1) + 2 * (int)((twos >> bit) & 1) + 4 * (int)((fours >> bit) & 1);
+						uint32 hashed = DungeonRandom::HashTile(seed, pass, OriginX + word * 64 + bit, OriginY + y);
+
+						// The more floor tiles the tile is touching, the more likely it is to be
+						// eroded. This will cause a more rounder look.
+						if (DungeonRandom::ToFraction(hashed) * 100 < m_erosionChance * adjacentFloorTiles)
+							erodedFloors[word] |= (uint64)1 << bit;
+					}
 				}
+			}
+		});
+
+		Swap(Floors, nextFloors);
+	}
+}
+/**********************************************************************************************************
+*	void WriteErodedFloors(const FloorBitboard & InitialFloors, const FloorBitboard & ErodedFloors)
+*		Purpose:	Writes back only the tiles that became floors during erosion.
+*
+*		Parameters:
+*			const FloorBitboard & InitialFloors
+*				The floors of the layout before erosion.
+*			const FloorBitboard & ErodedFloors
+*				The floors of the layout after erosion.
+*
+*		Changes:
+*			m_dungeonLayout - Tiles that were eroded are set to floor tiles.
+**********************************************************************************************************/
+void DungeonLayout::WriteErodedFloors(const FloorBitboard & InitialFloors, const FloorBitboard & ErodedFloors)
+{
+	int wordsPerRow = InitialFloors.GetWordsPerRow();
+
+	for (int y = 0; y < m_layoutHeight; y++)
+	{
+		const uint64 * initialRow = InitialFloors.GetRow(y);
+		const uint64 * finalRow = ErodedFloors.GetRow(y);
+		TileData * row = m_dungeonLayout + y * m_layoutWidth;
+
+		for (int word = 0; word < wordsPerRow; word++)
+		{
+			uint64 eroded = finalRow[word] & ~initialRow[word];
+
+			while (eroded != 0)
+			{
+				int bit = FloorBitboard::CountTrailingZeros(eroded);
+				eroded &= eroded - 1;
+
+				row[word * 64 + bit] = TileData(floorTile);
+			}
+		}
+	}
+}
+/**********************************************************************************************************
+*	void CreateTiles()
+*		Purpose:	Scans through each tile on the map and picks which tile will best fit the current
+*					location. The tile's type and rotation will be set to the tile that best solves the
+*					given scenario.
+*
+*		Changes:
+*			m_dungeonLayout - All tiles will be solved for.
+**********************************************************************************************************/
+void DungeonLayout::CreateTiles()
+{
+	if (m_dungeonLayout == nullptr)
+		return;
+
+	if (m_options.bParallelTileSolve)
+	{
+		CreateTilesParallel();
+		return;
+	}
+
+	if (m_options.TileSolveMode == ETileSolveMode::Frontier)
+	{
+		CreateTilesFrontier();
+		return;
+	}
+
+	for (int y = 0; y < m_layoutHeight; y++)
+	{
+		TileData * row = m_dungeonLayout + y * m_layoutWidth;
 
-				// If this child has not been tried before
-				if (childHasFailed == false)
-					removedARoom = DropRandomRoomRecursive(children[randomChild]);
+		for (int x = 0; x < m_layoutWidth; x++)
+		{
+			TileData solvedTile = row[x];
+
+			if (solvedTile.GetTileType() != TileType::floorTile)
+			{
+				bool successfulSolve = SolveTile(x, y, solvedTile);
 
-				if (removedARoom == false)
+				if (successfulSolve)
+					row[x] = solvedTile;
+				else
 				{
-					failedChildren[failedTries] = randomChild;
-					failedTries++;
+					// Unsolvable tile error.
 				}
-				// The child succeeded.
-				else
-					return true;
 			}
 		}
-		// This is a leaf node.
-		else
+	}
+}
+/**********************************************************************************************************
+*	void CompactDungeonLayout()
+*		Purpose:	Moves the finished tiles into m_sparseLayout and frees the grid. The grid was still
+*					filled, eroded and solved in full, and this is one more pass over it. Only the runs
+*					of tiles that are not empty are kept, so the memory held afterwards follows what was
+*					built instead of the size of the map.
+*
+*		Changes:
+*			m_sparseLayout - Holds the tiles.
+*			m_dungeonLayout - Freed.
+**********************************************************************************************************/
+void DungeonLayout::CompactDungeonLayout()
+{
+	if (m_dungeonLayout == nullptr)
+		return;
+
+	m_sparseLayout.Build(GetDungeonLayout());
+	FreeDungeonLayout();
+}
+/**********************************************************************************************************
+*	void CreateTilesFrontier()
+*		Purpose:	Frontier version of CreateTiles. Copies the floors into a FloorBitboard and solves each
+*					row with SolveRowFrontier. The result is the same as CreateTiles.
+*
+*		Changes:
+*			m_dungeonLayout - All tiles will be solved for.
+**********************************************************************************************************/
+void DungeonLayout::CreateTilesFrontier()
+{
+	FloorBitboard floors = FloorBitboard(GetDungeonLayout());
+
+	for (int y = 0; y < m_layoutHeight; y++)
+		SolveRowFrontier(floors, y);
+}
+/**********************************************************************************************************
+*	void CreateTilesParallel()
+*		Purpose:	Parallel version of CreateTiles. Solving a tile only reads whether its neighbors are
+*					floors, and solving never turns a tile into a floor, so once the floors are copied into
+*					a FloorBitboard every row can be solved on its own. The rows are split into bands of
+*					m_SOLVE_BAND_ROWS and each band is solved as a ParallelFor task. Tasks only read the
+*					bitboard and only write their own rows, so the result is identical to the serial solve
+*					no matter how the tasks are scheduled. Honors m_options.TileSolveMode.
+*
+*		Changes:
+*			m_dungeonLayout - All tiles will be solved for.
+**********************************************************************************************************/
+void DungeonLayout::CreateTilesParallel()
+{
+	FloorBitboard floors = FloorBitboard(GetDungeonLayout());
+
+	bool frontierOnly = m_options.TileSolveMode == ETileSolveMode::Frontier;
+	int bandCount = (m_layoutHeight + m_SOLVE_BAND_ROWS - 1) / m_SOLVE_BAND_ROWS;
+
+	ParallelFor(bandCount, [this, &floors, frontierOnly](int32 Band)
+	{
+		int firstRow = Band * m_SOLVE_BAND_ROWS;
+		int lastRow = FMath::Min(firstRow + m_SOLVE_BAND_ROWS, m_layoutHeight);
+
+		for (int y = firstRow; y < lastRow; y++)
+		{
+			if (frontierOnly)
+				SolveRowFrontier(floors, y);
+			else
+				SolveRow(floors, y);
+		}
+	});
+}
+/**********************************************************************************************************
+*	void PrepareChunks()
+*		Purpose:	Gets a generated tree and paths ready to be made into chunks. Every room and path is
+*					cut to the tiles it fills and filed under each row of chunks it can reach, so a chunk
+*					only has to look at the shapes in its own row. A shape is filed under a row if it comes
+*					within the chunk halo of it, the erosion passes plus the one tile the solver looks at.
+*					The rows are filed in two passes, one to count and one to fill, so the shapes of a row
+*					sit next to each other in m_chunkRects.
+*
+*		Changes:
+*			m_chunkRects, m_chunkRowFirstRect - Hold the shapes reaching each row of chunks.
+*			m_chunkCache - Emptied and sized for the chunks of the layout.
+**********************************************************************************************************/
+void DungeonLayout::PrepareChunks()
+{
+	int chunkSize = GetChunkSize();
+	int chunksX = (m_layoutWidth + chunkSize - 1) / chunkSize;
+	int chunksY = (m_layoutHeight + chunkSize - 1) / chunkSize;
+	int halo = m_erosionPasses + 1;
+
+	TArray<TileRect> shapes = GetFloorRects();
+
+	// Count the shapes reaching each row, then turn the counts into where each row starts.
+	m_chunkRowFirstRect.Init(0, chunksY + 1);
+
+	for (int i = 0; i < shapes.Num(); i++)
+	{
+		int firstRow = FMath::Max(shapes[i].yStart - halo, 0) / chunkSize;
+		int lastRow = FMath::Min((shapes[i].yEnd - 1 + halo) / chunkSize, chunksY - 1);
+
+		for (int row = firstRow; row <= lastRow; row++)
+			m_chunkRowFirstRect[row + 1]++;
+	}
+
+	for (int row = 0; row < chunksY; row++)
+		m_chunkRowFirstRect[row + 1] += m_chunkRowFirstRect[row];
+
+	TArray<int> rowNextRect = m_chunkRowFirstRect;
+	m_chunkRects.SetNumUninitialized(m_chunkRowFirstRect[chunksY]);
+
+	for (int i = 0; i < shapes.Num(); i++)
+	{
+		int firstRow = FMath::Max(shapes[i].yStart - halo, 0) / chunkSize;
+		int lastRow = FMath::Min((shapes[i].yEnd - 1 + halo) / chunkSize, chunksY - 1);
+
+		for (int row = firstRow; row <= lastRow; row++)
+			m_chunkRects[rowNextRect[row]++] = shapes[i];
+	}
+
+	SIZE_T memoryLimit = (SIZE_T)FMath::Max(m_options.ChunkCacheMegabytes, 1) * 1024 * 1024;
+	m_chunkCache.Reset(chunksX, chunksY, memoryLimit, (SIZE_T)chunkSize * chunkSize * sizeof(TileData));
+}
+/**********************************************************************************************************
+*	void GenerateChunk(int ChunkX, int ChunkY, DungeonChunk & Chunk)
+*		Purpose:	Makes the finished tiles of one chunk without the rest of the layout. The chunk is
+*					grown by a halo of m_erosionPasses + 1 tiles, cut off at the edges of the layout, and
+*					the rooms and paths reaching it are drawn into a FloorBitboard of that window. The
+*					window is eroded with ErodeFloorsHashed, which is exact for every tile at least
+*					m_erosionPasses from the window's edge, so the chunk and the ring of tiles around it
+*					hold the same floors as a full Hashed layout. That ring is all the solver needs to
+*					solve the chunk's own tiles.
+*
+*					Only reads the layout, so different chunks can be made on different threads at once.
+*
+*		Parameters:
+*			int ChunkX, int ChunkY
+*				The chunk. Must be inside the layout, which must be chunked and generated.
+*			DungeonChunk & Chunk
+*				Set to the tiles of the chunk.
+**********************************************************************************************************/
+void DungeonLayout::GenerateChunk(int ChunkX, int ChunkY, DungeonChunk & Chunk) const
+{
+	check(IsChunked() && ChunkX >= 0 && ChunkY >= 0 && ChunkX < GetNumChunksX() && ChunkY < GetNumChunksY());
+
+	int chunkSize = GetChunkSize();
+	int halo = m_erosionPasses + 1;
+
+	TileRect chunk = TileRect(ChunkX * chunkSize, ChunkY * chunkSize, (ChunkX + 1) * chunkSize, (ChunkY + 1) * chunkSize);
+	chunk = chunk.Intersect(TileRect(0, 0, m_layoutWidth, m_layoutHeight));
+
+	TileRect window = TileRect(chunk.xStart - halo, chunk.yStart - halo, chunk.xEnd + halo, chunk.yEnd + halo);
+	window = window.Intersect(TileRect(0, 0, m_layoutWidth, m_layoutHeight));
+
+	FloorBitboard floors = FloorBitboard(window.xEnd - window.xStart, window.yEnd - window.yStart);
+
+	for (int i = m_chunkRowFirstRect[ChunkY]; i < m_chunkRowFirstRect[ChunkY + 1]; i++)
+	{
+		TileRect tiles = m_chunkRects[i].Intersect(window);
+
+		if (tiles.IsEmpty())
+			continue;
+
+		for (int y = tiles.yStart; y < tiles.yEnd; y++)
+			floors.SetFloorSpan(y - window.yStart, tiles.xStart - window.xStart, tiles.xEnd - window.xStart);
+	}
+
+	ErodeFloorsHashed(floors, window.xStart, window.yStart);
+
+	Chunk.Reset(ChunkX, ChunkY, chunk.xStart, chunk.yStart, chunk.xEnd - chunk.xStart, chunk.yEnd - chunk.yStart);
+
+	TileLayoutView tiles = Chunk.GetTiles();
+
+	for (int y = 0; y < tiles.height; y++)
+		SolveChunkRow(floors, chunk.yStart + y - window.yStart, chunk.xStart - window.xStart, tiles.width, tiles.GetRow(y));
+}
+/**********************************************************************************************************
+*	void SolveChunkRow(const FloorBitboard & Floors, int Y, int XStart, int Count, TileData * Row)
+*		Purpose:	Writes the finished tiles of part of a row of a FloorBitboard. Floors become floor
+*					tiles, tiles touching a floor are run through the solver and the rest are empties. Like
+*					SolveRowFrontier, a word of the row with no floor near it is filled in one go.
+*
+*		Parameters:
+*			const FloorBitboard & Floors
+*				The finished floors. Must reach at least one tile past the part being solved wherever
+*				the layout does.
+*			int Y
+*				The row of Floors to solve.
+*			int XStart, int Count
+*				The first tile of Floors to solve and the number of tiles.
+*			TileData * Row
+*				Where to write the tiles, Count long.
+**********************************************************************************************************/
+void DungeonLayout::SolveChunkRow(const FloorBitboard & Floors, int Y, int XStart, int Count, TileData * Row) const
+{
+	TileData emptyTileData = TileData(emptyTile);
+	TileData floorTileData = TileData(floorTile);
+
+	int xEnd = XStart + Count;
+
+	for (int word = XStart >> 6; word <= (xEnd - 1) >> 6; word++)
+	{
+		// Dilate the floor by one tile in all 8 directions.
+		uint64 dilated = 0;
+
+		for (int adjY = Y - 1; adjY <= Y + 1; adjY++)
+			dilated |= Floors.GetWord(adjY, word) | Floors.GetWestNeighbors(adjY, word) | Floors.GetEastNeighbors(adjY, word);
+
+		int firstX = FMath::Max(word * 64, XStart);
+		int lastX = FMath::Min(word * 64 + 64, xEnd);
+
+		if (dilated == 0)
+		{
+			FMemory::Memset(Row + firstX - XStart, emptyTileData.packedTile, lastX - firstX);
+			continue;
+		}
+
+		uint64 floorWord = Floors.GetWord(Y, word);
+
+		for (int x = firstX; x < lastX; x++)
 		{
-			CurrentNode->SetRoom(Quad());
-			return true;
+			int bit = x & 63;
+
+			if ((floorWord >> bit) & 1)
+				Row[x - XStart] = floorTileData;
+			else if ((dilated >> bit) & 1)
+				Row[x - XStart] = TileSolver::SolveNeighborMask(TileSolver::GetNeighborMask(Floors, x, Y));
+			else
+				Row[x - XStart] = emptyTileData;
 		}
 	}
+}
+/**********************************************************************************************************
+*	Quad GenerateRandomRoom(Quad MaximumBounds, FRandomStream & Stream)
+*		Purpose:	Generates a random quad that fits inside MaximumBounds. This room has to be larger
+*					than m_minimumRoomSize.
+*
+*		Parameters:
+*			Quad MaximumBounds
+*				The Quad generated will fit inside this, respecting position as well as bounds.
+*			FRandomStream & Stream
+*				The stream to draw the room's corners from.
+*
+*		Return:		Returns a Quad that is at least as big as the minimum and fits inside the given space.
+**********************************************************************************************************/
+Quad DungeonLayout::GenerateRandomRoom(Quad MaximumBounds, FRandomStream & Stream)
+{
+	FVector TopRight = MaximumBounds.GetBounds();
+	FVector BottomLeft = MaximumBounds.GetPosition();
+
+	FVector BottomLeftMin = FVector(0, 0, 0);
+	FVector BottomLeftMax = FVector(0, 0, 0);
+	FVector TopRightMin = FVector(0, 0, 0);
+	FVector TopRightMax = FVector(0, 0, 0);
+
+	// The closest position the bottom left corner can be to the bottom left corner of the quad and still
+	// generate a room of minimumSize.
+	BottomLeftMin = BottomLeft;
+
+	// The closest position the bottom left corner can be to the top right corner and  still generate a
+	// room of at least minimumSize.
+	BottomLeftMax = TopRight - m_minimumRoomSize;
+
+	// Pick a random bottom left corner.
+	FVector newRoomPosition = FVector(0, 0, 0);
+	newRoomPosition.X = Stream.RandRange(BottomLeftMin.X, BottomLeftMax.X);
+	newRoomPosition.Y = Stream.RandRange(BottomLeftMin.Y, BottomLeftMax.Y);
+
+	// The closest position the top right corner can be to the bottom left of the quad and still
+	// generate a room of minimumSize.
+	TopRightMin = newRoomPosition + m_minimumRoomSize;
+
+	// The closest position the top right corner can be to the top right corner of the quad and still
+	// generate a room of minimumSize.
+	TopRightMax = TopRight;
 
-	return false;
+	// Pick a random top right corner.
+	FVector newRoomBounds = FVector(0, 0, 0);
+	newRoomBounds.X = Stream.RandRange((int)TopRightMin.X, (int)TopRightMax.X);
+	newRoomBounds.Y = Stream.RandRange((int)TopRightMin.Y, (int)TopRightMax.Y);
+
+	return Quad(newRoomBounds, newRoomPosition);
+}
+/**********************************************************************************************************
+*	void DropRandomRoom()
+*		Purpose:	Walks from the root to a leaf picking a random child at each level, then removes the
+*					leaf's room. Every branch has a leaf below it, so the first child picked at a level
+*					always leads to a leaf. The leaf's room is cleared even if it was already dropped.
+*
+*		Changes:
+*			m_linearTree - One leaf will have its room set to a room of size 0.
+**********************************************************************************************************/
+void DungeonLayout::DropRandomRoom()
+{
+	if (m_linearTree.Num() == 0)
+		return;
+
+	int node = 0;
+
+	while (!m_linearTree.GetNode(node).IsLeaf())
+		node = m_linearTree.GetNode(node).children[m_randomStream.RandRange(0, 3)];
+
+	m_linearTree.SetRoom(node, Quad());
 }
 /**********************************************************************************************************
-*	void GeneratePathBetweenQuads(Quad Room1, Quad Room2)
+*	void GeneratePathBetweenQuads(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 *		Purpose:	Generates a path connecting Room1 to Room2. If a quad can be created directly between
 *					the two rooms of width m_PathWidth, a straight away will be built. If the quad does
 *					not fit, 2 quads will instead form an L Bend. The paths generated can overlap with
@@ -669,13 +1915,17 @@ bool DungeonLayout::DropRandomRoomRecursive(QuadTreeNode * CurrentNode)
 *				One end of the path to build. The path built will connect to this quad.
 *			Quad Room2
 *				The other end of the path. The path built will connect to this quad.
+*			FRandomStream & Stream
+*				The stream to draw random numbers from.
+*			TArray<Quad> & Paths
+*				The list to add the paths to.
 *
 *		Changes:
-*			m_paths - Paths generated are stored here.
+*			Paths - Paths generated are added here.
 *
 *		Return: Returns if a path was built or not.
 **********************************************************************************************************/
-bool DungeonLayout::GeneratePathBetweenQuads(Quad Room1, Quad Room2)
+bool DungeonLayout::GeneratePathBetweenQuads(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 {
 	// Don't waist time if the room is 0 sized.
 	FVector Room1Size = Room1.GetBounds() - Room1.GetPosition();
@@ -687,15 +1937,15 @@ bool DungeonLayout::GeneratePathBetweenQuads(Quad Room1, Quad Room2)
 
 	bool PathGenerated = false;
 	// Attempt to generate a straight path Y aligned.
-	PathGenerated = GenerateYAlignedPath(Room1, Room2);
+	PathGenerated = GenerateYAlignedPath(Room1, Room2, Stream, Paths);
 
 	// Attempt to generate a straight path X aligned.
 	if (PathGenerated == false)
-		PathGenerated = GenerateXAlignedPath(Room1, Room2);
+		PathGenerated = GenerateXAlignedPath(Room1, Room2, Stream, Paths);
 
 	// Attempt to generate an L Bend.
 	if (PathGenerated == false)
-		PathGenerated = GenerateLBendPath(Room1, Room2);
+		PathGenerated = GenerateLBendPath(Room1, Room2, Stream, Paths);
 
 	//TODO: What happens if all these fail? A C bend? give up?
 
@@ -703,7 +1953,7 @@ bool DungeonLayout::GeneratePathBetweenQuads(Quad Room1, Quad Room2)
 	return PathGenerated;
 }
 /**********************************************************************************************************
-*	bool GenerateYAlignedPath(Quad Room1, Quad Room2)
+*	bool GenerateYAlignedPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 *		Purpose:	Attempts to create a path between the rooms passed in. The path generated will be
 *					m_pathWidth wide and will only generate if a straight path can be drawn from Room1 to
 *					Room2 along the Y axis. See GenerateXAlignedPath() for this functions counterpart.
@@ -713,13 +1963,17 @@ bool DungeonLayout::GeneratePathBetweenQuads(Quad Room1, Quad Room2)
 *				One end of the path to build. The path built will connect to this quad.
 *			Quad Room2
 *				The other end of the path. The path built will connect to this quad.
+*			FRandomStream & Stream
+*				The stream to draw random numbers from.
+*			TArray<Quad> & Paths
+*				The list to add the paths to.
 *
 *		Changes:
-*			m_paths - Paths generated are stored here.
+*			Paths - Paths generated are added here.
 *
 *		Return: Returns if a path was built or not.
 **********************************************************************************************************/
-bool DungeonLayout::GenerateYAlignedPath(Quad Room1, Quad Room2)
+bool DungeonLayout::GenerateYAlignedPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 {
 	//Find the room with the smaller width (X value).
 	Quad * smallerRoom;
@@ -804,10 +2058,10 @@ bool DungeonLayout::GenerateYAlignedPath(Quad Room1, Quad Room2)
 		higherRoom = &Room2;
 	}
 
-	int BuildXMinima = m_randomStream.RandRange(rangeMinima, rangeMaxima - m_pathWidth);
+	int BuildXMinima = Stream.RandRange(rangeMinima, rangeMaxima - m_pathWidth);
 
 	// Generate the path.
-	m_paths.Add(
+	Paths.Add(
 		Quad(FVector(BuildXMinima + m_pathWidth, higherRoom->GetPosition().Y, 0), 
 			 FVector(BuildXMinima, lowerRoom->GetBounds().Y, 0)));
 
@@ -815,7 +2069,7 @@ bool DungeonLayout::GenerateYAlignedPath(Quad Room1, Quad Room2)
 	return true;
 }
 /**********************************************************************************************************
-*	bool GenerateXAlignedPath(Quad Room1, Quad Room2)
+*	bool GenerateXAlignedPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 *		Purpose:	Attempts to create a path between the rooms passed in. The path generated will be
 *					m_pathWidth wide and will only generate if a straight path can be drawn from Room1 to
 *					Room2 along the X axis. See GenerateYAlignedPath() for this functions counterpart.
@@ -825,13 +2079,17 @@ bool DungeonLayout::GenerateYAlignedPath(Quad Room1, Quad Room2)
 *				One end of the path to build. The path built will connect to this quad.
 *			Quad Room2
 *				The other end of the path. The path built will connect to this quad.
+*			FRandomStream & Stream
+*				The stream to draw random numbers from.
+*			TArray<Quad> & Paths
+*				The list to add the paths to.
 *
 *		Changes:
-*			m_paths - Paths generated are stored here.
+*			Paths - Paths generated are added here.
 *
 *		Return: Returns if a path was built or not.
 **********************************************************************************************************/
-bool DungeonLayout::GenerateXAlignedPath(Quad Room1, Quad Room2)
+bool DungeonLayout::GenerateXAlignedPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 {
 	//Find the room with the smaller height (Y value).
 	Quad * smallerRoom;
@@ -916,10 +2174,10 @@ bool DungeonLayout::GenerateXAlignedPath(Quad Room1, Quad Room2)
 		rightRoom = &Room2;
 	}
 
-	int BuildYMinima = m_randomStream.RandRange(rangeMinima, rangeMaxima - m_pathWidth);
+	int BuildYMinima = Stream.RandRange(rangeMinima, rangeMaxima - m_pathWidth);
 
 	// Generate the path.
-	m_paths.Add(
+	Paths.Add(
 		Quad(FVector(rightRoom->GetPosition().X, BuildYMinima + m_pathWidth, 0), 
 			 FVector(leftRoom->GetBounds().X, BuildYMinima, 0)));
 
@@ -927,7 +2185,7 @@ bool DungeonLayout::GenerateXAlignedPath(Quad Room1, Quad Room2)
 	return true;
 }
 /**********************************************************************************************************
-*	bool GenerateLBendPath(Quad Room1, Quad Room2)
+*	bool GenerateLBendPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 *		Purpose:	Attempts to create an LBend to connect the two rooms.
 *
 *		Parameters:
@@ -935,15 +2193,19 @@ bool DungeonLayout::GenerateXAlignedPath(Quad Room1, Quad Room2)
 *				One end of the path to build. The path built will connect to this quad.
 *			Quad Room2
 *				The other end of the path. The path built will connect to this quad.
+*			FRandomStream & Stream
+*				The stream to draw random numbers from.
+*			TArray<Quad> & Paths
+*				The list to add the paths to.
 *
 *		Changes:
-*			m_paths - Paths generated are stored here.
+*			Paths - Paths generated are added here.
 *
 *		Return: Returns if a path was built or not.
 **********************************************************************************************************/
-bool DungeonLayout::GenerateLBendPath(Quad Room1, Quad Room2)
+bool DungeonLayout::GenerateLBendPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 {
-	int randomBendDirection = m_randomStream.RandRange(0, 1);
+	int randomBendDirection = Stream.RandRange(0, 1);
 
 	// Casting to bool not allowed.
 	bool randomBool = false;
@@ -956,17 +2218,17 @@ bool DungeonLayout::GenerateLBendPath(Quad Room1, Quad Room2)
 
 
 
-	succeeded = GenerateLBendPathWithKnownOrientation(Room1, Room2, randomBool);
+	succeeded = GenerateLBendPathWithKnownOrientation(Room1, Room2, randomBool, Stream, Paths);
 
 	// If the bend could not be completed try it the other way.
 	if (!succeeded)
-		succeeded = GenerateLBendPathWithKnownOrientation(Room1, Room2, !randomBool);
+		succeeded = GenerateLBendPathWithKnownOrientation(Room1, Room2, !randomBool, Stream, Paths);
 
 	// Return if a bend could be built.
 	return succeeded;
 }
 /**********************************************************************************************************
-*	bool GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2, bool xFirst)
+*	bool GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2, bool xFirst, FRandomStream & Stream, TArray<Quad> & Paths)
 *		Purpose:	Attempts to create an LBend to connect the two rooms. The lBend will only be attempted
 *					a single way. If xFirst is true, Room1 will have its path on the xAxis while Room2
 *					has its path on the yAxis. If false the inverse is true.
@@ -978,13 +2240,17 @@ bool DungeonLayout::GenerateLBendPath(Quad Room1, Quad Room2)
 *				The other end of the path. The path built will connect to this quad.
 *			bool xFirst
 *				If Room1 is the xAligned room.
+*			FRandomStream & Stream
+*				The stream to draw random numbers from.
+*			TArray<Quad> & Paths
+*				The list to add the paths to.
 *
 *		Changes:
-*			m_paths - Paths generated are stored here.
+*			Paths - Paths generated are added here.
 *
 *		Return: Returns if a path was built or not.
 **********************************************************************************************************/
-bool DungeonLayout::GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2, bool xFirst)
+bool DungeonLayout::GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2, bool xFirst, FRandomStream & Stream, TArray<Quad> & Paths)
 {
 	// Designate which room is xAligned and which is yAligned.
 	Quad * xAligned = nullptr;
@@ -1117,12 +2383,12 @@ bool DungeonLayout::GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2
 	// Randomly pick a location for the intersection.
 
 	// This is the y axis.
-	int xAlignedBuildLocation = m_randomStream.RandRange(
+	int xAlignedBuildLocation = Stream.RandRange(
 									xAlignedRoomBuildableRangeMinima,
 									xAlignedRoomBuildableRangeMaxima - m_pathWidth);
 
 	// This is the x axis.
-	int yAlignedBuildLocation = m_randomStream.RandRange(
+	int yAlignedBuildLocation = Stream.RandRange(
 									yAlignedRoomBuildableRangeMinima,
 									yAlignedRoomBuildableRangeMaxima - m_pathWidth);
 
@@ -1134,10 +2400,10 @@ bool DungeonLayout::GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2
 
 	// build paths to the intersection.
 
-	bool XGenerated = GenerateXAlignedPath(*xAligned, intersection);
-	bool YGenerated = GenerateYAlignedPath(*yAligned, intersection);
+	bool XGenerated = GenerateXAlignedPath(*xAligned, intersection, Stream, Paths);
+	bool YGenerated = GenerateYAlignedPath(*yAligned, intersection, Stream, Paths);
 
-	// If either of those failed, garbage could have been created in the m_paths array. Warn about this.
+	// If either of those failed, garbage could have been added to Paths. Warn about this.
 	if (!(XGenerated && YGenerated))
 	{
 		UE_LOG(LogTemp, Warning, TEXT("Critical Error building path, path array may be corrupted."));
@@ -1145,180 +2411,237 @@ bool DungeonLayout::GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2
 	}
 	
 	// Add the intersection to paths.
-	m_paths.Add(intersection);
+	Paths.Add(intersection);
 
 	return true;
 }
 /**********************************************************************************************************
-*	void GeneratePathsRecursive(QuadTreeNode * CurrentNode)
-*		Purpose:	Connects the set of rooms belonging to each child passed in current node with a path.
-*					The path can either be direct or indirect but each set will be reachable through
-*					one of the siblings. This process is repeated down the tree connecting all sets of
-*					sibling nodes.
+*	void GeneratePathsForNode(int NodeIndex, FRandomStream & Stream, TArray<Quad> & Paths)
+*		Purpose:	Connects the children of a branch node to each other. 3 of the 4 siblings are
+*					connected to the sibling next to them, or diagonal from them if there are no rooms
+*					next to them. The siblings will have at most a single connection but are guaranteed to
+*					be at least indirectly connected.
 *
 *		Parameters:
-*			QuadTreeNode * CurrentNode
-*				The highest level of the tree to connect siblings at.
+*			int NodeIndex
+*				The index of a branch node in m_linearTree.
+*			FRandomStream & Stream
+*				The stream to draw random numbers from.
+*			TArray<Quad> & Paths
+*				The list to add the paths to.
 *
 *		Changes:
-*			m_paths - New paths will be added to the array.
+*			Paths - Paths between siblings are added here.
 **********************************************************************************************************/
-void DungeonLayout::GeneratePathsRecursive(QuadTreeNode * CurrentNode)
+void DungeonLayout::GeneratePathsForNode(int NodeIndex, FRandomStream & Stream, TArray<Quad> & Paths)
 {
-	if (CurrentNode != nullptr)
+	const int * children = m_linearTree.GetNode(NodeIndex).children;
+
+	// Pick a random number to not generate a path for.
+	int DontBuildPathIndex = Stream.FRandRange(0, 3);
+
+	// Pick a random point on the intersect between each sibling.
+
+	// ORDER:
+	// 0 = Bottom Left
+	// 1 = Top Left
+	// 2 = Top Right
+	// 3 = Bottom Right
+
+	Quad currentChildQuad = Quad();
+	FVector randomPointBetweenQuads = FVector(0, 0, 0);
+	int randomMin = 0;
+	int randomMax = 0;
+
+	// Go through each of the 4 children finding a random point along
+	// the edge that can be connected to each other child.
+	// EG: Since child 0 is the bottom left, find a random point along
+	// its top edge to connect to child 1 (top left quad).
+	for (int i = 0; i < 4; i++)
 	{
-		QuadTreeNode ** children = CurrentNode->GetChildren();
-		
-		// If this node has children
-		if (children != nullptr && children[0] != nullptr)
+		if (i != DontBuildPathIndex)
 		{
-			// Pick a random number to not generate a path for.
-			int DontBuildPathIndex = m_randomStream.FRandRange(0, 3);
-
-			// Pick a random point on the intersect between each sibling.
+			currentChildQuad = m_linearTree.GetNode(children[i]).quad;
 
-			// ORDER:
+			// Switch will result in getting a random point.
+			switch (i)
+			{
 			// 0 = Bottom Left
+			case 0:
+				randomMin = currentChildQuad.GetPosition().X;
+				randomMax = currentChildQuad.GetBounds().X;
+				randomPointBetweenQuads.Y = currentChildQuad.GetBounds().Y;
+				randomPointBetweenQuads.X = Stream.RandRange(randomMin, randomMax);
+				break;
 			// 1 = Top Left
+			case 1:
+				randomMin = currentChildQuad.GetPosition().Y;
+				randomMax = currentChildQuad.GetBounds().Y;
+				randomPointBetweenQuads.X = currentChildQuad.GetBounds().X;
+				randomPointBetweenQuads.Y = Stream.RandRange(randomMin, randomMax);
+				break;
 			// 2 = Top Right
+			case 2:
+				randomMin = currentChildQuad.GetPosition().X;
+				randomMax = currentChildQuad.GetBounds().X;
+				randomPointBetweenQuads.Y = currentChildQuad.GetPosition().Y;
+				randomPointBetweenQuads.X = Stream.RandRange(randomMin, randomMax);
+				break;
 			// 3 = Bottom Right
+			case 3:
+				randomMin = currentChildQuad.GetPosition().Y;
+				randomMax = currentChildQuad.GetBounds().Y;
+				randomPointBetweenQuads.X = currentChildQuad.GetPosition().X;
+				randomPointBetweenQuads.Y = Stream.RandRange(randomMin, randomMax);
+				break;
+			default:
+				break;
+			}
 
-			Quad currentChildQuad = Quad();
-			FVector randomPointBetweenQuads = FVector(0, 0, 0);
-			int randomMin = 0;
-			int randomMax = 0;
+			// Find the closest room belonging to child i.
+			Quad room1 = FindClosestRoom(children[i], randomPointBetweenQuads);
+			Quad room2 = Quad();
 
-			// Go through each of the 4 children finding a random point along
-			// the edge that can be connected to each other child.
-			// EG: Since child 0 is the bottom left, find a random point along
-			// its top edge to connect to child 1 (top left quad).
-			for (int i = 0; i < 4; i++)
+			// If there are no rooms to connect to, give up.
+			if (room1.GetBounds() != FVector(0, 0, 0))
 			{
-				if (i != DontBuildPathIndex)
+				// This for loop allows the connection of diagonal rooms if there isn't
+				// a room at child[i+1].
+				for (int j = 0; room2.GetBounds() == FVector(0, 0, 0) && j < 2; j++)
 				{
-					currentChildQuad = children[i]->GetQuad();
-
-					// Switch will result in getting a random point.
-					switch (i)
-					{
-					// 0 = Bottom Left
-					case 0:
-						randomMin = currentChildQuad.GetPosition().X;
-						randomMax = currentChildQuad.GetBounds().X;
-						randomPointBetweenQuads.Y = currentChildQuad.GetBounds().Y;
-						randomPointBetweenQuads.X = m_randomStream.RandRange(randomMin, randomMax);
-						break;
-					// 1 = Top Left
-					case 1:
-						randomMin = currentChildQuad.GetPosition().Y;
-						randomMax = currentChildQuad.GetBounds().Y;
-						randomPointBetweenQuads.X = currentChildQuad.GetBounds().X;
-						randomPointBetweenQuads.Y = m_randomStream.RandRange(randomMin, randomMax);
-						break;
-					// 2 = Top Right
-					case 2:
-						randomMin = currentChildQuad.GetPosition().X;
-						randomMax = currentChildQuad.GetBounds().X;
-						randomPointBetweenQuads.Y = currentChildQuad.GetPosition().Y;
-						randomPointBetweenQuads.X = m_randomStream.RandRange(randomMin, randomMax);
-						break;
-					// 3 = Bottom Right
-					case 3:
-						randomMin = currentChildQuad.GetPosition().Y;
-						randomMax = currentChildQuad.GetBounds().Y;
-						randomPointBetweenQuads.X = currentChildQuad.GetPosition().X;
-						randomPointBetweenQuads.Y = m_randomStream.RandRange(randomMin, randomMax);
-						break;
-					default:
-						break;
-					}
-
-					// Find the closest room belonging to child i.
-					Quad room1 = FindClosestRoom(children[i], randomPointBetweenQuads);
-					Quad room2 = Quad();
-
-					// If there are no rooms to connect to, give up.
-					if (room1.GetBounds() != FVector(0, 0, 0))
-					{
-						// This for loop allows the connection of diagonal rooms if there isn't
-						// a room at child[i+1].
-						for (int j = 0; room2.GetBounds() == FVector(0, 0, 0) && j < 2; j++)
-						{
-							// Find the closest room belonging to the child next to this, or, if that
-							// doesn't exist, the child diagonal from this.
-							room2 = FindClosestRoom(children[(i + j + 1) % 4], randomPointBetweenQuads);
-						}
-
-						// If 2 rooms were found generate a path between them.
-						if (room2.GetBounds() != FVector(0, 0, 0))
-							GeneratePathBetweenQuads(room1, room2);
-					}
+					// Find the closest room belonging to the child next to this, or, if that
+					// doesn't exist, the child diagonal from this.
+					room2 = FindClosestRoom(children[(i + j + 1) % 4], randomPointBetweenQuads);
 				}
-			}
 
-			for (int i = 0; i < 4; i++)
-			{
-				// Call this function on each child.
-				GeneratePathsRecursive(children[i]);
+				// If 2 rooms were found generate a path between them.
+				if (room2.GetBounds() != FVector(0, 0, 0))
+					GeneratePathBetweenQuads(room1, room2, Stream, Paths);
 			}
-
 		}
 	}
 }
 /**********************************************************************************************************
-*	Quad FindClosestRoom(QuadTreeNode * ParentNode, FVector Point)
-*		Purpose:	Searches the tree passed in at parent node for the room that is closest to the point
-*					passed in. The distance to the point is calculated at the center of each edge. This
-*					is to ensure that room size does not affect distance to the point.
+*	Quad FindClosestRoom(int NodeIndex, FVector Point)
+*		Purpose:	Picks the room below a node to connect to Point. The original recursive search never
+*					replaced the first room it found with a closer one, so the room picked is the first
+*					room in the node's subtree. This is kept so layouts do not change for a seed. The
+*					leaves of the subtree are one contiguous run, so this is a short loop.
+*
+*					If m_options.bNearestRoomSearch is set the room whose closest edge center is nearest
+*					Point is picked instead, see FindNearestRoom.
+*
+*		Parameters:
+*			int NodeIndex
+*				The index of the node in m_linearTree to search under.
+*			FVector Point
+*				The point to connect to.
+*
+*		Return:		The room picked, or a room of size 0 if there are no rooms below the node.
+**********************************************************************************************************/
+Quad DungeonLayout::FindClosestRoom(int NodeIndex, FVector Point)
+{
+	if (m_options.bNearestRoomSearch)
+		return FindNearestRoom(NodeIndex, Point);
+
+	const LinearQuadTreeNode & node = m_linearTree.GetNode(NodeIndex);
+
+	for (int i = node.firstLeaf; i < node.endLeaf; i++)
+	{
+		const LinearQuadTreeNode & leaf = m_linearTree.GetLeaf(i);
+
+		if (leaf.HasRoom())
+			return leaf.room;
+	}
+
+	return Quad();
+}
+/**********************************************************************************************************
+*	Quad FindNearestRoom(int NodeIndex, FVector Point)
+*		Purpose:	Finds the room below a node whose closest edge center is nearest Point. Edge centers
+*					lie inside their room, and every room lies inside the cached room bounds of the nodes
+*					above it, so no room below a node can be nearer than the node's bounds. The search
+*					takes the nearest subtree first and skips any subtree whose bounds are farther than
+*					the best room found so far. For a map with thousands of rooms this visits a handful
+*					of nodes per level instead of every leaf. Ties go to the room first in depth first
+*					order, so the result does not depend on the visiting order.
 *
 *		Parameters:
-*			QuadTreeNode * ParentNode
-*				The tree to find rooms in.
+*			int NodeIndex
+*				The index of the node in m_linearTree to search under.
 *			FVector Point
-*				The point to find a room near.
+*				The point to connect to.
 *
-*		Return: Returns the room that is the closest to the point given.
+*		Return:		The nearest room, or a room of size 0 if there are no rooms below the node.
 **********************************************************************************************************/
-Quad DungeonLayout::FindClosestRoom(QuadTreeNode * ParentNode, FVector Point)
+Quad DungeonLayout::FindNearestRoom(int NodeIndex, FVector Point)
 {
-	Quad closestRoom = Quad();
+	// Each node taken off the stack puts at most 3 more on than it took off, so this only grows past
+	// the inline storage on very deep trees.
+	TArray<int, TInlineAllocator<64>> nodesToSearch;
+	nodesToSearch.Add(NodeIndex);
+
+	float bestDistance = MAX_flt;
+	int bestLeaf = -1;
 
-	if (ParentNode != nullptr)
+	while (nodesToSearch.Num() > 0)
 	{
-		QuadTreeNode ** children = ParentNode->GetChildren();
-		// If this node has children.
-		if (children != nullptr && children[0] != nullptr)
+		int nodeIndex = nodesToSearch.Pop();
+		const LinearQuadTreeNode & node = m_linearTree.GetNode(nodeIndex);
+
+		if (node.roomCount == 0)
+			continue;
+
+		// The best room may have got closer since this node was put on the stack.
+		float boundsDistance = m_linearTree.GetRoomBoundsDistanceSquared(nodeIndex, Point);
+
+		if (boundsDistance > bestDistance || (boundsDistance == bestDistance && node.firstLeaf > bestLeaf))
+			continue;
+
+		if (node.IsLeaf())
 		{
-			Quad newClosestRoom = Quad();
-			float newDistance = 0;
-			float oldDistance = 0;
+			float distance = (FindCenterOfClosestEdge(node.room, Point) - Point).SizeSquared();
 
-			for (int i = 0; i < 4; i++)
+			if (distance < bestDistance || (distance == bestDistance && node.firstLeaf < bestLeaf))
 			{
-				newClosestRoom = FindClosestRoom(children[i], Point);
-				
-				// If the newClosestRoom has an area.
-				if (newClosestRoom.GetBounds() != FVector(0, 0, 0))
-					newDistance = (FindCenterOfClosestEdge(newClosestRoom, Point) - Point).Size();
-
-				// If there is an old closest room and a new closest room compare the values.
-				if (closestRoom.GetBounds() != FVector(0, 0, 0) && newClosestRoom.GetBounds() != FVector(0, 0, 0))
-				{
-					oldDistance = (FindCenterOfClosestEdge(closestRoom, Point) - Point).Size();
+				bestDistance = distance;
+				bestLeaf = node.firstLeaf;
+			}
 
-					if (newDistance < oldDistance)
-						newClosestRoom = closestRoom;
-				}
-				else if (closestRoom.GetBounds() == FVector(0, 0, 0))
-					closestRoom = newClosestRoom;
+			continue;
+		}
+
+		// Push the children farthest first so the nearest is searched next.
+		int children[4];
+		float childDistances[4];
+
+		for (int i = 0; i < 4; i++)
+		{
+			int child = node.children[i];
+			float childDistance = m_linearTree.GetRoomBoundsDistanceSquared(child, Point);
+			int j = i;
+
+			for (; j > 0 && childDistances[j - 1] < childDistance; j--)
+			{
+				children[j] = children[j - 1];
+				childDistances[j] = childDistances[j - 1];
 			}
 
+			children[j] = child;
+			childDistances[j] = childDistance;
+		}
+
+		for (int i = 0; i < 4; i++)
+		{
+			if (childDistances[i] <= bestDistance)
+				nodesToSearch.Add(children[i]);
 		}
-		else
-			closestRoom = ParentNode->GetRoom();
 	}
 
-	return closestRoom;
+	if (bestLeaf < 0)
+		return Quad();
+
+	return m_linearTree.GetLeaf(bestLeaf).room;
 }
 /**********************************************************************************************************
 *	FVector FindCenterOfClosestEdge(Quad Room, FVector Point)
@@ -1365,6 +2688,92 @@ FVector DungeonLayout::FindCenterOfClosestEdge(Quad Room, FVector Point)
 	return centerPoint;
 }
 /**********************************************************************************************************
+*	static int GetTreeDepth(int DesiredRooms)
+*		Purpose:	Finds how many times the quad tree is cut to make room for the rooms asked for.
+*
+*		Parameters:
+*			int DesiredRooms
+*				The number of rooms to try and create.
+*
+*		Return:		log4(DesiredRooms) rounded up, or 1 if no rooms are asked for.
+**********************************************************************************************************/
+int DungeonLayout::GetTreeDepth(int DesiredRooms)
+{
+	int depth = 1;
+
+	if (DesiredRooms > 0)
+		depth = ceil(log(DesiredRooms) / log(4));
+
+	return depth;
+}
+/**********************************************************************************************************
+*	static bool CanGenerate(FVector DungeonSize, int PathWidth)
+*		Purpose:	Checks the parameters a dungeon can not be made without.
+*
+*		Parameters:
+*			FVector DungeonSize
+*				The size of the dungeon.
+*			int PathWidth
+*				The width of all paths between rooms.
+*
+*		Return:		True if the dungeon and its paths will have area.
+**********************************************************************************************************/
+bool DungeonLayout::CanGenerate(FVector DungeonSize, int PathWidth)
+{
+	// Verify that the dungeon will have area.
+	bool OKToGenerate = floor(DungeonSize.X) > 0 && floor(DungeonSize.Y) > 0;
+	// Verify the paths will have area.
+	OKToGenerate = OKToGenerate && PathWidth > 0;
+
+	return OKToGenerate;
+}
+/**********************************************************************************************************
+*	void AllocateDungeonLayout()
+*		Purpose:	Allocates the tile buffer for the current m_dungeonDimensions. All tiles are stored in
+*					one row-major block so the whole layout costs a single allocation. Any decimal in the
+*					dimensions is thrown out. The tiles are left uninitialized. A chunked layout only takes
+*					the size, its tiles are made a chunk at a time.
+*
+*		Changes:
+*			m_dungeonLayout - Points to a new buffer or nullptr if the dimensions have no area or the
+*				layout is chunked.
+*			m_layoutWidth - Set to the number of tiles in a row.
+*			m_layoutHeight - Set to the number of rows.
+**********************************************************************************************************/
+void DungeonLayout::AllocateDungeonLayout()
+{
+	FreeDungeonLayout();
+
+	int width = (int)floor(m_dungeonDimensions.X);
+	int height = (int)floor(m_dungeonDimensions.Y);
+
+	if (width > 0 && height > 0)
+	{
+		m_layoutWidth = width;
+		m_layoutHeight = height;
+
+		if (!m_options.bChunkedGeneration)
+			m_dungeonLayout = new TileData[m_layoutWidth * m_layoutHeight];
+	}
+}
+/**********************************************************************************************************
+*	void FreeDungeonLayout()
+*		Purpose:	Frees the tile buffer.
+*
+*		Changes:
+*			m_dungeonLayout - Deleted and set to nullptr.
+*			m_layoutWidth, m_layoutHeight - Set to 0.
+**********************************************************************************************************/
+void DungeonLayout::FreeDungeonLayout()
+{
+	if (m_dungeonLayout != nullptr)
+		delete[] m_dungeonLayout;
+
+	m_dungeonLayout = nullptr;
+	m_layoutWidth = 0;
+	m_layoutHeight = 0;
+}
+/**********************************************************************************************************
 *	void ClearDungeonLayout()
 *		Purpose:	Replaces all values in the dungeon layout with empty.
 *
@@ -1373,23 +2782,17 @@ FVector DungeonLayout::FindCenterOfClosestEdge(Quad Room, FVector Point)
 **********************************************************************************************************/
 void DungeonLayout::ClearDungeonLayout()
 {
-	TileData blankTile = TileData();
-
-	blankTile.tileType = emptyTile;
-	blankTile.tileRotation = FRotator(0, 0, 0);
+	TileData blankTile = TileData(emptyTile);
 
-	for (int y = 0; y < m_dungeonDimensions.Y; y++)
-	{
-		for (int x = 0; x < m_dungeonDimensions.X; x++)
-		{
-			m_dungeonLayout[y][x] = blankTile;
-			m_dungeonLayout[y][x].tileLocation = FVector2D(x, y);
-		}
-	}
+	// Tiles are a single byte so the whole layout can be filled at once.
+	if (m_dungeonLayout != nullptr)
+		FMemory::Memset(m_dungeonLayout, blankTile.packedTile, m_layoutWidth * m_layoutHeight);
 }
 /**********************************************************************************************************
-*	void CreateFloorQuad(Quad Room)
-*		Purpose:	Changes all tiles inside the given quad to floor tiles in the dungeon layout.
+*	int CreateFloorQuad(Quad Room)
+*		Purpose:	Changes all tiles inside the given quad to floor tiles in the dungeon layout. The quad
+*					is cut into one span per row, each span is filled with a single memset and kept in
+*					m_floorSpans.
 *
 *		Parameters:
 *			Quad Room
@@ -1398,8 +2801,42 @@ void DungeonLayout::ClearDungeonLayout()
 *		Changes:
 *			m_dungeonLayout - All array elements falling within the bounds of Room will be changed to 
 *							  floor tiles.
+*			m_floorSpans - The spans of Room are added.
+*
+*		Return:		The number of tiles filled.
+**********************************************************************************************************/
+int DungeonLayout::CreateFloorQuad(Quad Room)
+{
+	if (m_dungeonLayout == nullptr)
+		return 0;
+
+	TileRect tiles = GetFloorQuadTiles(Room);
+
+	if (tiles.IsEmpty())
+		return 0;
+
+	// Tiles are a single byte so a span is filled at once.
+	TileData newFloor = TileData(floorTile);
+
+	for (int y = tiles.yStart; y < tiles.yEnd; y++)
+	{
+		FMemory::Memset(m_dungeonLayout + y * m_layoutWidth + tiles.xStart, newFloor.packedTile, tiles.xEnd - tiles.xStart);
+		m_floorSpans.Add(TileSpan(y, tiles.xStart, tiles.xEnd));
+	}
+
+	return (tiles.xEnd - tiles.xStart) * (tiles.yEnd - tiles.yStart);
+}
+/**********************************************************************************************************
+*	TileRect GetFloorQuadTiles(Quad Room)
+*		Purpose:	Finds the tiles CreateFloorQuad fills for a quad.
+*
+*		Parameters:
+*			Quad Room
+*				The Quad that will be changed to floor tiles.
+*
+*		Return:		The tiles inside Room, cut down to fit inside the layout. Empty if none are.
 **********************************************************************************************************/
-void DungeonLayout::CreateFloorQuad(Quad Room)
+TileRect DungeonLayout::GetFloorQuadTiles(Quad Room) const
 {
 	// If the quad passed in has bad bounds resize it to fit inside the level.
 	FVector bottomLeftCorner = Room.GetPosition();
@@ -1409,39 +2846,20 @@ void DungeonLayout::CreateFloorQuad(Quad Room)
 		bottomLeftCorner.X = 0;
 	if (bottomLeftCorner.Y < 0)
 		bottomLeftCorner.Y = 0;
-	if (topRightCorner.X > m_dungeonDimensions.X)
-		topRightCorner.X = m_dungeonDimensions.X;
-	if (topRightCorner.Y > m_dungeonDimensions.Y)
-		topRightCorner.Y = m_dungeonDimensions.Y;
-
-	// Create a floor tile.
-	TileData newFloor = TileData();
-	newFloor.tileType = floorTile;
-	newFloor.tileRotation = FRotator(0, 0, 0);
-	int randomRotation = 0;
+	if (topRightCorner.X > m_layoutWidth)
+		topRightCorner.X = m_layoutWidth;
+	if (topRightCorner.Y > m_layoutHeight)
+		topRightCorner.Y = m_layoutHeight;
 
-	if (m_dungeonLayout != nullptr)
-	{
-		for (int y = bottomLeftCorner.Y; y < topRightCorner.Y; y++)
-		{
-			for (int x = bottomLeftCorner.X; x < topRightCorner.X; x++)
-			{
-				// Pick a random rotation for the floor tile.
-				randomRotation = m_randomStream.RandRange(0, 3);
-				randomRotation *= 90;
-				//newFloor.tileRotation.Yaw = randomRotation;
-
-				// Assign the tile.
-				m_dungeonLayout[y][x] = newFloor;
-			}
-		}
-	}
+	// The same tiles the old per tile loops from the corners to below the far corners covered.
+	return TileRect((int)bottomLeftCorner.X, (int)bottomLeftCorner.Y, FMath::CeilToInt(topRightCorner.X), FMath::CeilToInt(topRightCorner.Y));
 }
 /**********************************************************************************************************
 *	bool SolveTile(int X, int Y, TileData& TileOut)
 *		Purpose:	Attempts to solve the tile so that it completes the dungeon walls without leaving any
 *					gaps. This function should be called on empties. When called on an empty, the
-*					surrounding tiles are checked to see what the best tile in this slot would be.
+*					surrounding floors are packed into a neighbor mask and the solved tile is looked up in
+*					TileSolver's table.
 *
 *		Parameters:
 *			int X
@@ -1459,333 +2877,102 @@ bool DungeonLayout::SolveTile(int X, int Y, TileData& TileOut)
 		return false;
 
 	// Valid tile?
-	if (X < 0 || X >= m_dungeonDimensions.X || Y < 0 || Y >= m_dungeonDimensions.Y)
+	if (!IsValidTile(X, Y))
 		return false;
 
-	TArray<FVector2D> adjFloors = TArray<FVector2D>();
-	TArray<FVector2D> adjOthers = TArray<FVector2D>();
-
-	TArray<FVector2D> cornerFloors = TArray<FVector2D>();
-	TArray<FVector2D> cornerOthers = TArray<FVector2D>();
-
-	// DATA COLLECTION
-
-	// Get surrounding tile data.
-	// NOTE: For standard rotation the y axis will be backwards.
-	for (int yOffset = -1; yOffset <= 1; yOffset++)
-	{
-		for (int xOffset = -1; xOffset <= 1; xOffset++)
-		{
-			// bounds check.
-			if (Y + yOffset >= 0 && X + xOffset >= 0 && Y + yOffset < m_dungeonDimensions.Y && X + xOffset < m_dungeonDimensions.X)
-			{
-				// XOR - get tiles adjacent to the center.
-				if ((xOffset != 0) != (yOffset != 0))
-				{
-					// mark each tile adjacent to the center
-					if (m_dungeonLayout[Y + yOffset][X + xOffset].tileType == TileType::floorTile)
-						adjFloors.Add(FVector2D(xOffset, -yOffset));
-					else
-						adjOthers.Add(FVector2D(xOffset, -yOffset));
-				}
-				else
-				{
-					// mark each corner to the center.
-					if (m_dungeonLayout[Y + yOffset][X + xOffset].tileType == TileType::floorTile)
-						cornerFloors.Add(FVector2D(xOffset, -yOffset));
-					else
-						cornerOthers.Add(FVector2D(xOffset, -yOffset));
-				}
-			}
-			else
-			{
-				// XOR - get tiles adjacent to the center.
-				if ((xOffset != 0) != (yOffset != 0))
-					adjOthers.Add(FVector2D(xOffset, -yOffset));
-				else
-					cornerOthers.Add(FVector2D(xOffset, -yOffset));
-			}
-		}
-	}
-
-	// DECISION MAKING
-
 	// Floor tiles should be considered already solved, avoid solving a floor tile if you can.
-	if (TileOut.tileType == TileType::floorTile)
-	{
-		TileOut.tileRotation = FRotator::ZeroRotator;
-		return true;
-	}
-
-
-	// Empty.
-	if (adjFloors.Num() == 0 && cornerFloors.Num() == 0)
-	{
-		TileOut.tileType = TileType::emptyTile;
-		TileOut.tileRotation = FRotator::ZeroRotator;
-		return true;
-	}
-
-	// Pillar or floor.
-	else if (adjFloors.Num() == 4)
-	{
-		TileOut.tileType = TileType::pillarTile;
-
-		TileOut.tileRotation = FRotator::ZeroRotator;
-		return true;
-	}
-
-	// 1 sided wall or T junction or Wall corner composite
-	else if (adjFloors.Num() == 1)
-	{
-
-		TileOut.tileType = TileType::oneSidedWallTile;
-		float angle = FMath::RadiansToDegrees(FMath::Atan2(adjFloors[0].Y, adjFloors[0].X));
-
-		angle = FMath::RoundToFloat(angle);
-
-		if (angle < 0)
-			angle += 360;
-
-		TileOut.tileRotation = FRotator(0, -angle, 0);
-		
-		for (int i = 0; i < cornerFloors.Num(); i++)
-		{
-			float cornerFloorAngle = FMath::RadiansToDegrees(FMath::Atan2(cornerFloors[i].Y, cornerFloors[i].X));
-
-			cornerFloorAngle = FMath::RoundToFloat(cornerFloorAngle);
-
-			if (cornerFloorAngle < 0)
-				cornerFloorAngle += 360;
-			
-			if (cornerFloorAngle == FMath::Fmod(angle + 135, 360))
-			{
-				if (TileOut.tileType == TileType::oneSidedWallTile)
-					TileOut.tileType = TileType::wallCornerCompositeTile;
-				else
-					TileOut.tileType = TileType::tJuctionTile;
-			}
-			else if (cornerFloorAngle == FMath::Fmod(angle + 225, 360))
-			{
-				if (TileOut.tileType == TileType::oneSidedWallTile)
-					TileOut.tileType = TileType::wallCornerCompositeReversedTile;
-				else
-					TileOut.tileType = TileType::tJuctionTile;
-			}
-
-		}
-
-		
-		return true;
-
-
-
-	}
-
-	// 3 sided wall.
-	else if (adjFloors.Num() == 3)
+	if (TileOut.GetTileType() == TileType::floorTile)
 	{
-		TileOut.tileType = TileType::threeSidedWallTile;
-
-		// Set the angle to the floor tile across from the other tile.
-		float angle = FMath::Atan2(-adjOthers[0].Y, -adjOthers[0].X);
-
-		TileOut.tileRotation = FRotator(0, -FMath::RadiansToDegrees(angle), 0);
-
+		TileOut.SetQuarterTurns(0);
 		return true;
 	}
 
-	// Outside corner or 2 sided wall or L bend.
-	else if (adjFloors.Num() == 2)
-	{
-		// 2 sided wall.
-		if (adjFloors[0].X + adjFloors[1].X == 0)
-		{
-			TileOut.tileType = TileType::twoSidedWallTile;
-
-			float angle = FMath::Atan2(adjFloors[0].Y, adjFloors[0].X);
-
-			TileOut.tileRotation = FRotator(0, -FMath::RadiansToDegrees(angle), 0);
-
-			return true;
-		}
-		// Outside corner or L Bend.
-		else
-		{
-			TileOut.tileType = TileType::outsideCornerTile;
-
-			for (int i = 0; i < cornerFloors.Num(); i++)
-			{
-				// if there is a corner floor opposite the two legs
-				if (cornerFloors[i].X == -(adjFloors[0].X + adjFloors[1].X) &&
-					cornerFloors[i].Y == -(adjFloors[0].Y + adjFloors[1].Y))
-				{
-					// This is an L bend.
-					TileOut.tileType = TileType::lBendTile;
-					break;
-				}
-			}
-
-			float angle0 = FMath::Atan2(adjFloors[0].Y, adjFloors[0].X);
-			if (angle0 < 0)
-				angle0 += 2.0F * PI;
-
-			float angle1 = FMath::Atan2(adjFloors[1].Y, adjFloors[1].X);
-			if (angle1 < 0)
-				angle1 += 2.0F * PI;
-
-			// Find the clockwise-most leg of the right triangle the two angles form.
-			if (angle1 == FMath::Fmod(angle0 + (PI / 2.0F), 2.0F * PI))
-				TileOut.tileRotation = FRotator(0, -FMath::RadiansToDegrees(angle0), 0);
-			else
-				TileOut.tileRotation = FRotator(0, -FMath::RadiansToDegrees(angle1), 0);
-
-			return true;
-		}
-	}
-
-	// Inside corner.
-	else if (adjFloors.Num() == 0 && cornerFloors.Num() > 0)
-	{
-		// The number of diagonal floors corresponds to the type of tile.
-		switch (cornerFloors.Num())
-		{
-		//Single corner
-		case 1:
-		{
-			TileOut.tileType = TileType::insideSingleCornerTile;
-			// subtract pi/4 for the clockwise-most leg.
-			float angle = FMath::Atan2(cornerFloors[0].Y, cornerFloors[0].X) - PI / 4;
-			TileOut.tileRotation = FRotator(0, -FMath::RadiansToDegrees(angle), 0);
-			break;
-		}
-		// Double corner
-		case 2:
-		{
-			// Opposite inside double corner.
-			if (cornerFloors[0].X + cornerFloors[1].X == 0 && cornerFloors[0].Y + cornerFloors[1].Y == 0)
-			{
-				TileOut.tileType = TileType::insideDoubleOppositeCornerTile;
-				float angle = FMath::Atan2(cornerFloors[0].Y, cornerFloors[0].X) - PI / 4;
-				TileOut.tileRotation = FRotator(0, -FMath::RadiansToDegrees(angle), 0);
-			}
-			// Adjacent inside double corner.
-			else
-			{
-				TileOut.tileType = TileType::insideDoubleAdjacentCornerTile;
-
-				float angle0 = FMath::Atan2(cornerFloors[0].Y, cornerFloors[0].X);
-				if (angle0 < 0)
-					angle0 += 2.0F * PI;
-				float angle1 = FMath::Atan2(cornerFloors[1].Y, cornerFloors[1].X);
-				if (angle1 < 0)
-					angle1 += 2.0F * PI;
-
-				// Find the clockwise-most leg of the right triangle the two angles form.
-				if (angle1 == FMath::Fmod(angle0 + (PI / 2.0F), 2.0F * PI))
-					TileOut.tileRotation = FRotator(0, -FMath::RadiansToDegrees(angle0 - PI / 4), 0);
-				else
-					TileOut.tileRotation = FRotator(0, -FMath::RadiansToDegrees(angle1 - PI / 4), 0);
-			}
-			break;
-		}
-		// Triple corner.
-		case 3:
-		{
-			TileOut.tileType = TileType::insideTripleCornerTile;
-			// subtract pi/4 for the clockwise-most leg.
-			float angle = FMath::Atan2(-cornerOthers[0].Y, -cornerOthers[0].X) - PI / 4;
-			TileOut.tileRotation = FRotator(0, -FMath::RadiansToDegrees(angle), 0);
-			break;
-		}
-		// Quadra corner.
-		case 4:
-		{
-			TileOut.tileType = TileType::insideQuadraCornerTile;
-			TileOut.tileRotation = FRotator::ZeroRotator;
-			break;
-		}
-		default:
-			return false;
-		}
-
-		return true;
-	}
+	TileOut = TileSolver::SolveNeighborMask(TileSolver::GetNeighborMask(GetDungeonLayout(), X, Y));
 
-	return false;
+	return true;
 }
 /**********************************************************************************************************
-*	int CountRoomsRecursive(QuadTreeNode * CurrentNode)
-*		Purpose:	Counts all the rooms below this in the tree. This includes the current node.
+*	void SolveRow(const FloorBitboard & Floors, int Y)
+*		Purpose:	Solves every tile in row Y that is not a floor. Neighbors are read from Floors instead
+*					of the layout, so other rows can be written while this runs.
 *
 *		Parameters:
-*			QuadTreeNode * CurrentNode
-*				The highest node in the tree to search.
+*			const FloorBitboard & Floors
+*				The floors of the layout before solving.
+*			int Y
+*				The row to solve.
 *
-*		Return:
-*			Returns the number of rooms found.
+*		Changes:
+*			m_dungeonLayout - The tiles in row Y are solved for.
 **********************************************************************************************************/
-int DungeonLayout::CountRoomsRecursive(QuadTreeNode * CurrentNode)
+void DungeonLayout::SolveRow(const FloorBitboard & Floors, int Y)
 {
-	int roomSum = 0;
+	TileData * row = m_dungeonLayout + Y * m_layoutWidth;
 
-	if (CurrentNode != nullptr)
+	for (int x = 0; x < m_layoutWidth; x++)
 	{
-		QuadTreeNode ** children = CurrentNode->GetChildren();
-
-		// If this node has children
-		if (children != nullptr && children[0] != nullptr)
-		{
-			for (int i = 0; i < 4; i++)
-			{
-				roomSum += CountRoomsRecursive(children[i]);
-			}
-		}
-		else
-		{
-			if (CurrentNode->GetRoom().GetBounds() != FVector(0, 0, 0))
-				roomSum++;
-		}
+		if (row[x].GetTileType() != TileType::floorTile)
+			row[x] = TileSolver::SolveNeighborMask(TileSolver::GetNeighborMask(Floors, x, Y));
 	}
-
-	return roomSum;
 }
 /**********************************************************************************************************
-*	TArray<Quad> GetListOfAllRoomsRecursive(QuadTreeNode * CurrentNode)
-*		Purpose:	Gets a list of all rooms below this in the tree. This includes this node.
+*	void SolveRowFrontier(const FloorBitboard & Floors, int Y)
+*		Purpose:	Frontier version of SolveRow. A tile with no floor in its 3x3 neighborhood can only
+*					be solved to an empty, so the floor is dilated by one tile to find the frontier: every
+*					non floor tile that touches a floor. Only the frontier is run through the solver,
+*					everything else that is not a floor is filled with empties a word at a time.
 *
 *		Parameters:
-*			QuadTreeNode * CurrentNode
-*				The highest node in the tree to search.
+*			const FloorBitboard & Floors
+*				The floors of the layout before solving.
+*			int Y
+*				The row to solve.
 *
-*		Return:
-*			Returns a list of every room found.
+*		Changes:
+*			m_dungeonLayout - The tiles in row Y are solved for.
 **********************************************************************************************************/
-TArray<Quad> DungeonLayout::GetListOfAllRoomsRecursive(QuadTreeNode * CurrentNode)
+void DungeonLayout::SolveRowFrontier(const FloorBitboard & Floors, int Y)
 {
-	TArray<Quad> allRooms = TArray<Quad>();
+	const uint64 * floorRow = Floors.GetRow(Y);
+	TileData * row = m_dungeonLayout + Y * m_layoutWidth;
+	TileData emptyTileData = TileData(emptyTile);
 
-	if (CurrentNode != nullptr)
+	for (int word = 0; word < Floors.GetWordsPerRow(); word++)
 	{
-		QuadTreeNode ** children = CurrentNode->GetChildren();
+		// Dilate the floor by one tile in all 8 directions.
+		uint64 dilated = 0;
 
-		// If this node has children
-		if (children != nullptr && children[0] != nullptr)
+		for (int adjY = Y - 1; adjY <= Y + 1; adjY++)
+			dilated |= Floors.GetWord(adjY, word) | Floors.GetWestNeighbors(adjY, word) | Floors.GetEastNeighbors(adjY, word);
+
+		uint64 validBits = Floors.GetValidBits(word);
+		uint64 frontier = dilated & ~floorRow[word] & validBits;
+		uint64 empties = ~dilated & validBits;
+
+		int firstX = word * 64;
+
+		// Fill the empties in bulk. A word with no floor near it is filled in one go.
+		if (empties == validBits)
 		{
-			for (int i = 0; i < 4; i++)
-			{
-				TArray<Quad> childRooms = GetListOfAllRoomsRecursive(children[i]);
+			FMemory::Memset(row + firstX, emptyTileData.packedTile, FMath::Min(64, m_layoutWidth - firstX));
+			continue;
+		}
 
-				for (int j = 0; j < childRooms.Num(); j++)
-					allRooms.Add(childRooms[j]);
-			}
+		while (empties != 0)
+		{
+			int bit = FloorBitboard::CountTrailingZeros(empties);
+			empties &= empties - 1;
+
+			row[firstX + bit] = emptyTileData;
 		}
-		else
+
+		// Solve the frontier.
+		while (frontier != 0)
 		{
-			if (CurrentNode->GetRoom().GetBounds() != FVector(0, 0, 0))
-				allRooms.Add(CurrentNode->GetRoom());
+			int bit = FloorBitboard::CountTrailingZeros(frontier);
+			frontier &= frontier - 1;
+
+			row[firstX + bit] = TileSolver::SolveNeighborMask(TileSolver::GetNeighborMask(Floors, firstX + bit, Y));
 		}
 	}
-
-	return allRooms;
 }
\ No newline at end of file
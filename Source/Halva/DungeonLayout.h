@@ -3,6 +3,59 @@
 #pragma once
 #include "TileStructure.h"
 #include "QuadTreeNode.h"
+#include "QuadTreeNodeArena.h"
+#include "LinearQuadTree.h"
+#include "FloorBitboard.h"
+#include "SparseTileLayout.h"
+#include "DungeonChunkCache.h"
+#include "TileSolver.h"
+#include "DungeonRandom.h"
+#include "DungeonGenerationOptions.h"
+#include "DungeonGenerationProgress.h"
+/**********************************************************************************************************
+*	enum: EDungeonStage
+*
+*	Overview:
+*		The stages of generating a DungeonLayout, in the order they run. Each stage only depends on the
+*		ones before it and its own parameters, see DungeonLayout::Regenerate.
+*
+*	Options:
+*		Tree
+*			Cutting the dungeon into a quad tree.
+*		Rooms
+*			Making a room in every leaf and dropping the extras.
+*		Paths
+*			Connecting the rooms.
+*		Tiles
+*			Filling in, eroding and solving the tiles.
+*		None
+*			No stage.
+**********************************************************************************************************/
+enum class EDungeonStage : uint8
+{
+	Tree,
+	Rooms,
+	Paths,
+	Tiles,
+	None
+};
+/**********************************************************************************************************
+*	struct FloorEdit
+*
+*		Purpose:
+*			An edit queued by DungeonLayout::SetFloorRect.
+*
+*		Members:
+*			TileRect rect
+*				The tiles to edit, inside the layout.
+*			bool bFloor
+*				If the tiles become floors or lose their floors.
+**********************************************************************************************************/
+struct FloorEdit
+{
+	TileRect rect;
+	bool bFloor;
+};
 /**********************************************************************************************************
 *	Class: DungeonLayout
 *
@@ -11,25 +64,37 @@
 *		array with information about the tile at each location. No actual tiles are generated or handled
 *		by this class. This class operates with a QuadTree to generate rooms and decide passageways.
 *
+*		A chunked layout only keeps the tree and the paths. Its tiles are made a square chunk at a time
+*		when asked for through GetChunk, so maps far too large to hold as a full grid can be generated.
+*
 *	Manager Functions:
 *
 *		DungeonLayout();
 *			Default constructor. Generates an empty dungeon.
-*		DungeonLayout(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth, FRandomStream RNG);
+*		DungeonLayout(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth,
+*					  int ErosionPasses, float ErosionChance, FRandomStream RNG, FDungeonGenerationOptions Options,
+*					  DungeonGenerationProgress * Progress);
 *			Constructor. Generates a dungeon that has an area of DungeonSize given that each tile has an
 *			area of 1. No rooms shall be generated that are smaller than MinimumRoomSize and all passage
-*			ways will have a width of PathWidth.
+*			ways will have a width of PathWidth. Options picks the algorithms used for each step. If
+*			Progress is given, each stage is reported to it and generation stops if it is cancelled.
 *		DungeonLayout(const DungeonLayout & source);
 *			Copy constructor. takes in source and creates a copy of it.
+*		DungeonLayout(DungeonLayout && source);
+*			Move constructor. Takes the tree and tiles of source without copying them.
 *		~DungeonLayout();
 *			Destructor.
 *		DungeonLayout & operator=(const DungeonLayout & source);
 *			Assignment operator.
+*		DungeonLayout & operator=(DungeonLayout && source);
+*			Move assignment operator.
 *
 *	Mutators:
 *
 *		DungeonLayout
 *			-Get
+*		Tile
+*			-Get
 *		DungeonDimensions
 *			-Get
 *			-Set
@@ -39,83 +104,185 @@
 *		PathWidth
 *			-Get
 *			-Set
+*		FloorSpans
+*			-Get
+*		SparseLayout
+*			-Get
+*		ChunkSize
+*			-Get
+*		NumChunksX
+*			-Get
+*		NumChunksY
+*			-Get
+*		Chunk
+*			-Get
 *	Methods:
 *
+*		bool IsValidTile(int X, int Y)
+*			Returns if (X, Y) is inside the dungeon layout.
+*		bool IsSparse()
+*			Returns if the tiles are only held in m_sparseLayout.
+*		bool IsChunked()
+*			Returns if the tiles are made a chunk at a time instead of held in m_dungeonLayout.
+*		bool SetFloor(int X, int Y, bool Floor)
+*			Queues an edit making one tile a floor or taking its floor away.
+*		bool SetFloorRect(TileRect Rect, bool Floor)
+*			Queues an edit making a rectangle of tiles floors or taking their floors away.
+*		bool HasDirtyTiles()
+*			Returns if there are edits waiting to be resolved.
+*		void ResolveDirtyTiles(TArray<TileChange> & ChangedTiles)
+*			Applies the queued edits, solves only the tiles within one tile of them and reports every
+*			tile that changed.
+*		void GenerateChunk(int ChunkX, int ChunkY, DungeonChunk & Chunk)
+*			Makes the finished tiles of one chunk of a chunked layout, the same tiles a full layout
+*			eroded with EErosionMode::Hashed would have there.
+*		void ErodeFloorsHashed(FloorBitboard & Floors, int OriginX, int OriginY)
+*			Runs the EErosionMode::Hashed erosion on a window of the layout. Gives the same floors as
+*			eroding the whole layout for every tile further than m_erosionPasses from the window's edge.
 *		void GenerateDungeonLayout()
 *			Creates a complete dungeon tile map to be used. If one was already present, it is overwritten.
+*		EDungeonStage Regenerate(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth,
+*								 int ErosionPasses, float ErosionChance, FRandomStream RNG,
+*								 FDungeonGenerationOptions Options, DungeonGenerationProgress * Progress)
+*			Brings the layout up to date with new parameters, only re-running the stages they affect.
+*		void GenerateFromStage(EDungeonStage FirstStage)
+*			Runs every stage from FirstStage on. The tree must already be made.
+*		bool FinishStage(EDungeonStage Stage)
+*			Reports a stage as done to m_progress and returns if generation should go on.
+*		bool IsCancelled()
+*			Returns if m_progress has been cancelled.
+*		void GenerateTiles()
+*			Fills in, erodes and solves the tiles from the rooms and paths.
 *		void GenerateRooms()
 *			Generates a set of rooms and populates m_rooms.
 *		void DropRooms()
 *			Drops random rooms until the number of rooms existing is not larger than m_targetNumberRooms.
+*		void DropRoomsShuffle()
+*			DropRooms for ERoomDropMode::Shuffle. Drops a uniformly random set of rooms in one pass.
 *		void GeneratePaths()
 *			Generates a set of paths between rooms and populates m_paths.
+*		void GeneratePathsParallel()
+*			GeneratePaths for bParallelPathGeneration. Generates the paths of batches of branches on
+*			worker threads, each branch with its own stream.
 *		void CreateRoomLayout()
 *			Sets the values in the m_dungeonLayout 2d array to match the values in m_rooms and m_paths.
 *			The resulting layout will only be made of walls and empties.
 *		void ErodeRoomLayout()
 *			Causes the edges of rooms and paths to be replaced with floors in a random fashion. This
 *			allows rooms generated to look more natural than perfect rectangles if desired.
+*		void ErodeRoomLayoutBitboard()
+*			ErodeRoomLayout for EErosionMode::Bitboard. Erodes 64 tiles at a time using a FloorBitboard,
+*			each pass only sees the result of the pass before it.
+*		void ErodeRoomLayoutHashed()
+*			ErodeRoomLayout for EErosionMode::Hashed. Runs ErodeFloorsHashed on the whole layout.
+*		void WriteErodedFloors(const FloorBitboard & InitialFloors, const FloorBitboard & ErodedFloors)
+*			Writes the tiles that are floors in ErodedFloors but not in InitialFloors to the layout.
 *		void CreateTiles()
 *			Scans over each tile and picks the tile that best solves the scenario.
+*		void CreateTilesFrontier()
+*			CreateTiles for ETileSolveMode::Frontier. Only solves tiles next to a floor and fills the
+*			rest with empties.
+*		void CreateTilesParallel()
+*			CreateTiles for bParallelTileSolve. Solves bands of rows on worker threads.
+*		void CompactDungeonLayout()
+*			Moves the finished tiles into m_sparseLayout and frees m_dungeonLayout.
+*		void PrepareChunks()
+*			Files the rooms and paths under each row of chunks they can reach and sizes m_chunkCache.
+*		void SolveChunkRow(const FloorBitboard & Floors, int Y, int XStart, int Count, TileData * Row)
+*			Writes the finished floors, walls and empties of part of a row of Floors to Row.
+*		void SolveRow(const FloorBitboard & Floors, int Y)
+*			Solves every non floor tile in row Y using the floors in Floors.
+*		void SolveRowFrontier(const FloorBitboard & Floors, int Y)
+*			Solves the tiles next to a floor in row Y and fills the rest of the row with empties.
 *		int CountRooms()
 *			Counts all rooms in the dungeon.
+*		void ForEachRoom(TFunctionRef<void(const Quad &)> Visitor)
+*			Calls Visitor on each room in the dungeon without making a list of them.
 *		TArray<Quad> GetListOfAllRooms()
 *			Returns a list of each room in the dungeon.
-*		void GenerateRoomRecursive(QuadTreeNode * CurrentNode)
-*			Finds all the children below this node and creates a random room for them. The room is then
-*			added to m_rooms.
-*		Quad GenerateRandomRoom(Quad MaximumBounds)
+*		TArray<TileRect> GetFloorRects()
+*			Returns the tiles filled by each room and path, cut to fit inside the layout.
+*		Quad GenerateRandomRoom(Quad MaximumBounds, FRandomStream & Stream)
 *			Creates a random Quad within MaximumBounds that is at least the size of m_minimumRoomSize.
-*		bool DropRandomRoomRecursive(QuadTreeNode * CurrentNode)
-*			Follows the tree down from CurrentNode until a leaf node is found. The room from this leaf
-*			node is removed from m_rooms.
-*		bool GeneratePathBetweenQuads(Quad Room1, Quad Room2)
-*			Generates a path between the two rooms passed in and places the path in m_paths.
-*		bool GenerateYAlignedPath(Quad Room1, Quad Room2)
+*		void DropRandomRoom()
+*			Follows the tree down from the root picking random children until a leaf node is found. The
+*			room from this leaf node is removed.
+*		bool GeneratePathBetweenQuads(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
+*			Generates a path between the two rooms passed in and adds the path to Paths.
+*		bool GenerateYAlignedPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 *			Attempts to generate a path along the Y axis between the two rooms. If it turns out the rooms
 *			are not Y aligned, no path is generated.
-*		bool GenerateXAlignedPath(Quad Room1, Quad Room2)
+*		bool GenerateXAlignedPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 *			Attempts to generate a path along the X axis between the two rooms. If it turns out the rooms
 *			are not X aligned, no path is generated.
-*		bool GenerateLBendPath(Quad Room1, Quad Room2)
+*		bool GenerateLBendPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths)
 *			Attempts to generate a path in the shape of an L bend between the two rooms.
-*		bool GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2, bool xFirst)
+*		bool GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2, bool xFirst, FRandomStream & Stream, TArray<Quad> & Paths)
 *			Attempts to generate an L bend between the two rooms. Will only attempt one direction based
 *			on the bool xFirst.
-*		void GeneratePathsRecursive(QuadTreeNode * CurrentNode)
-*			Walks down the tree connecting all siblings it finds along the way. The siblings will have at
-*			most a single connection but are guaranteed to be at least indirectly connected.
-*		Quad FindClosestRoom(QuadTreeNode * ParentNode, FVector Point)
-*			Finds the room that is closest to the point given in the tree. The distance is calculated at
-*			the edge of the room.
+*		void GeneratePathsForNode(int NodeIndex, FRandomStream & Stream, TArray<Quad> & Paths)
+*			Connects the children of a branch node. The siblings will have at most a single connection
+*			but are guaranteed to be at least indirectly connected.
+*		Quad FindClosestRoom(int NodeIndex, FVector Point)
+*			Picks the room below the node to connect to the point given.
+*		Quad FindNearestRoom(int NodeIndex, FVector Point)
+*			Finds the room below the node nearest the point given, skipping subtrees that are too far.
 *		FVector FindCenterOfClosestEdge(Quad Room, FVector Point)
 *			Finds the center of the edge that is closest to the point given.
+*		static int GetTreeDepth(int DesiredRooms)
+*			Returns the depth of quad tree needed for DesiredRooms.
+*		static bool CanGenerate(FVector DungeonSize, int PathWidth)
+*			Returns if a dungeon can be made with the parameters given.
+*		void AllocateDungeonLayout()
+*			Allocates m_dungeonLayout as a single row-major buffer sized to m_dungeonDimensions.
+*		void FreeDungeonLayout()
+*			Frees m_dungeonLayout.
 *		void ClearDungeonLayout()
 *			Clears all tiles in the created room leaving only empty in each slot.
-*		void CreateFloorQuad(Quad Room)
+*		int CreateFloorQuad(Quad Room)
 *			All array elements in the dungeon layout that are contained within Room are changed to floor
 *			tiles.
-*		TileData SolveTile(int XPositon, int YPosition, TileData& TileOut)
+*		TileRect GetFloorQuadTiles(Quad Room)
+*			Returns the tiles CreateFloorQuad fills for Room.
+*		bool SolveTile(int XPositon, int YPosition, TileData& TileOut)
 *			Determines the type of tile and the rotation of the tile needed to complete the dungeon wall.
-*		int CountRoomsRecursive(QuadTreeRoot * CurrentNode)
-*			Counts all rooms below this in the tree including this node.
-*		TArray<Quad> GetListOfAllRoomsRecursive(QuadTreeRoot * CurrentNode)
-*			returns a list of all rooms below this node in the tree including this node.
+*			The answer is looked up by neighbor mask, see TileSolver.
 *
 *	Data Members:
 *
-*		QuadTreeNode m_quadTreeRoot
-*			The root of the quad tree.
+*		LinearQuadTree m_linearTree
+*			The quad tree flattened into an array. The pointer tree is only built to be flattened and
+*			is freed straight after. The generation steps walk this, and the rooms are stored in its
+*			leaves.
 *		TArray<Quad> m_paths
 *			A list of all the paths in the dungeon.
+*		TArray<TileSpan> m_floorSpans
+*			The rows of tiles each room and path covers, in the order they were filled. Spans of
+*			different shapes can overlap. Erosion is not included.
+*		SparseTileLayout m_sparseLayout
+*			The finished tiles when m_options.bSparseTileStorage is set. m_dungeonLayout is freed then.
+*		TArray<TileRect> m_chunkRects
+*			The tiles of each room and path reaching each row of chunks when the layout is chunked,
+*			grouped by row. A shape reaching more than one row is in the list once for each.
+*		TArray<int> m_chunkRowFirstRect
+*			Where each row of chunks starts in m_chunkRects, plus one past the last at the end. Empty
+*			until a chunked layout is generated.
+*		DungeonChunkCache m_chunkCache
+*			The most recently used chunks of a chunked layout, kept under m_options.ChunkCacheMegabytes.
+*		TArray<FloorEdit> m_floorEdits
+*			The edits waiting for ResolveDirtyTiles, in the order they were made.
 *		int m_roomCount
 *			The number of rooms contained in this dungeon.
 *		int m_targetNumberRooms
 *			The number of rooms to create on generation. If this number is too large instead the maximum
 *			number of rooms will be given instead dependent on level size and minimum room size.
-*		TileData ** m_dungeonLayout
-*			Holds all the information needed to pick a tile in each element. This will be an array of 
-*			arrays but will be used as a simple 2D array.
+*		TileData * m_dungeonLayout
+*			Holds all the information needed to pick a tile in each element. This is a single row-major
+*			buffer, tile (X, Y) is stored at m_dungeonLayout[Y * m_layoutWidth + X].
+*		int m_layoutWidth
+*			The number of tiles in each row of m_dungeonLayout.
+*		int m_layoutHeight
+*			The number of rows in m_dungeonLayout.
 *		FVector m_dungeonDimensions
 *			The maximum dimensions of the dungeon. This is how many tiles across the level will be once
 *			generated.
@@ -125,10 +292,35 @@
 *			The width of all paths between rooms or other paths.
 *		FRandomStream m_randomStream 
 *			Stream for generating random numbers.
+*		int32 m_seed
+*			The seed m_randomStream started from. Kept apart since the stream is replaced when it is
+*			skipped ahead.
+*		FRandomStream m_initialStream
+*			m_randomStream as it was given to the constructor.
+*		FRandomStream m_roomsStream
+*			m_randomStream as it was after the rooms were made and dropped.
+*		FRandomStream m_pathsStream
+*			m_randomStream as it was after the paths were made.
+*		bool m_generated
+*			If the layout has been generated. Regenerate rebuilds everything if not. Stays false if
+*			generation was cancelled part way.
+*		DungeonGenerationProgress * m_progress
+*			Where progress is reported during the constructor or Regenerate, nullptr otherwise. Not
+*			copied or moved.
 *		int m_erosionPasses
 *			The number of times to attempt to replace edges with floor, making the room appear jagged.
 *		float m_erosionChance
 *			The chance of a wall being replaced with a floor on an erosion pass.
+*		FDungeonGenerationOptions m_options
+*			Picks which algorithm is used for the generation steps that have more than one.
+*		static const int m_SOLVE_BAND_ROWS
+*			The number of rows each task solves in CreateTilesParallel.
+*		static const int m_EROSION_BAND_ROWS
+*			The number of rows each task erodes in ErodeFloorsHashed.
+*		static const int m_PATH_BATCH_NODES
+*			The number of branches each task connects in GeneratePathsParallel.
+*		static const int m_MINIMUM_CHUNK_SIZE
+*			The smallest chunk size used, whatever m_options.ChunkSize asks for.
 **********************************************************************************************************/
 class HALVA_API DungeonLayout
 {
@@ -136,65 +328,127 @@ public:
 
 	// Manager functions
 	DungeonLayout();
-	DungeonLayout(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth, int ErosionPasses, float ErosionChance, FRandomStream RNG);
+	DungeonLayout(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth, int ErosionPasses, float ErosionChance, FRandomStream RNG, FDungeonGenerationOptions Options = FDungeonGenerationOptions(), DungeonGenerationProgress * Progress = nullptr);
 	DungeonLayout(const DungeonLayout & source);
+	DungeonLayout(DungeonLayout && source);
 	~DungeonLayout();
 
 	DungeonLayout & operator=(const DungeonLayout & source);
+	DungeonLayout & operator=(DungeonLayout && source);
 
 	// Mutators
-	TileData ** GetDungeonLayout();
+	TileLayoutView GetDungeonLayout();
+	TileData & GetTile(int X, int Y);
 	FVector GetDungeonDimensions();
 	void SetDungeonDimensions(FVector DungeonDimensions);
 	FVector GetMinimumRoomSize();
 	void SetMinimumRoomSize(FVector MinimumRoomSize);
 	int GetPathWidth();
 	void SetPathWidth(int PathWidth);
+	const TArray<TileSpan> & GetFloorSpans() const;
+	const SparseTileLayout & GetSparseLayout() const;
+	int GetChunkSize() const;
+	int GetNumChunksX() const;
+	int GetNumChunksY() const;
+	const DungeonChunk & GetChunk(int ChunkX, int ChunkY);
 
-	int CountRooms();
-	TArray<Quad> GetListOfAllRooms();
+	int CountRooms() const;
+	void ForEachRoom(TFunctionRef<void(const Quad &)> Visitor) const;
+	TArray<Quad> GetListOfAllRooms() const;
+	TArray<TileRect> GetFloorRects() const;
+	bool IsValidTile(int X, int Y) const;
+	bool IsSparse() const;
+	bool IsChunked() const;
+	void GenerateChunk(int ChunkX, int ChunkY, DungeonChunk & Chunk) const;
+
+	// Editing
+	bool SetFloor(int X, int Y, bool Floor);
+	bool SetFloorRect(TileRect Rect, bool Floor);
+	bool HasDirtyTiles() const;
+	void ResolveDirtyTiles(TArray<TileChange> & ChangedTiles);
+	void ErodeFloorsHashed(FloorBitboard & Floors, int OriginX, int OriginY) const;
 
 	//  Dungeon Generation
 	void GenerateDungeonLayout();
+	EDungeonStage Regenerate(FVector DungeonSize, FVector MinimumRoomSize, int DesiredRooms, int PathWidth, int ErosionPasses, float ErosionChance, FRandomStream RNG, FDungeonGenerationOptions Options, DungeonGenerationProgress * Progress = nullptr);
 
 private:
 
 	// Dungeon generation steps
 	void GenerateRooms();
 	void DropRooms();
+	void DropRoomsShuffle();
 	void GeneratePaths();
+	void GeneratePathsParallel();
 	void CreateRoomLayout();
 	void CreateTiles();
+	void CreateTilesFrontier();
+	void CreateTilesParallel();
+	void GenerateFromStage(EDungeonStage FirstStage);
+	bool FinishStage(EDungeonStage Stage);
+	bool IsCancelled() const;
+	void GenerateTiles();
+	void CompactDungeonLayout();
+	void PrepareChunks();
+	void SolveChunkRow(const FloorBitboard & Floors, int Y, int XStart, int Count, TileData * Row) const;
 	void ErodeRoomLayout();
+	void ErodeRoomLayoutBitboard();
+	void ErodeRoomLayoutHashed();
+	void WriteErodedFloors(const FloorBitboard & InitialFloors, const FloorBitboard & ErodedFloors);
 
 	// Helper functions
-	void GenerateRoomRecursive(QuadTreeNode * CurrentNode);
-	Quad GenerateRandomRoom(Quad MaximumBounds);
-	bool DropRandomRoomRecursive(QuadTreeNode * CurrentNode);
-	bool GeneratePathBetweenQuads(Quad Room1, Quad Room2);
-	bool GenerateYAlignedPath(Quad Room1, Quad Room2);
-	bool GenerateXAlignedPath(Quad Room1, Quad Room2);
-	bool GenerateLBendPath(Quad Room1, Quad Room2);
-	bool GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2, bool xFirst);
-	void GeneratePathsRecursive(QuadTreeNode * CurrentNode);
-	Quad FindClosestRoom(QuadTreeNode * ParentNode, FVector Point);
+	Quad GenerateRandomRoom(Quad MaximumBounds, FRandomStream & Stream);
+	void DropRandomRoom();
+	bool GeneratePathBetweenQuads(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths);
+	bool GenerateYAlignedPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths);
+	bool GenerateXAlignedPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths);
+	bool GenerateLBendPath(Quad Room1, Quad Room2, FRandomStream & Stream, TArray<Quad> & Paths);
+	bool GenerateLBendPathWithKnownOrientation(Quad Room1, Quad Room2, bool xFirst, FRandomStream & Stream, TArray<Quad> & Paths);
+	void GeneratePathsForNode(int NodeIndex, FRandomStream & Stream, TArray<Quad> & Paths);
+	Quad FindClosestRoom(int NodeIndex, FVector Point);
+	Quad FindNearestRoom(int NodeIndex, FVector Point);
 	FVector FindCenterOfClosestEdge(Quad Room, FVector Point);
+	static int GetTreeDepth(int DesiredRooms);
+	static bool CanGenerate(FVector DungeonSize, int PathWidth);
+	void AllocateDungeonLayout();
+	void FreeDungeonLayout();
 	void ClearDungeonLayout();
-	void CreateFloorQuad(Quad Room);
+	int CreateFloorQuad(Quad Room);
+	TileRect GetFloorQuadTiles(Quad Room) const;
 	bool SolveTile(int XPosition, int YPosition, TileData& TileOut);
-	int CountRoomsRecursive(QuadTreeNode * CurrentNode);
-	TArray<Quad> GetListOfAllRoomsRecursive(QuadTreeNode * CurrentNode);
+	void SolveRow(const FloorBitboard & Floors, int Y);
+	void SolveRowFrontier(const FloorBitboard & Floors, int Y);
 
 
 	// member variables
-	QuadTreeNode m_quadTreeRoot;
+	LinearQuadTree m_linearTree;
 	TArray<Quad> m_paths;
+	TArray<TileSpan> m_floorSpans;
+	SparseTileLayout m_sparseLayout;
+	TArray<TileRect> m_chunkRects;
+	TArray<int> m_chunkRowFirstRect;
+	DungeonChunkCache m_chunkCache;
+	TArray<FloorEdit> m_floorEdits;
 	int m_targetNumRooms;
-	TileData ** m_dungeonLayout;
+	TileData * m_dungeonLayout;
+	int m_layoutWidth;
+	int m_layoutHeight;
 	FVector m_dungeonDimensions;
 	FVector m_minimumRoomSize;
 	int m_pathWidth;
 	int m_erosionPasses;
 	float m_erosionChance;
 	FRandomStream m_randomStream;
+	int32 m_seed;
+	FRandomStream m_initialStream;
+	FRandomStream m_roomsStream;
+	FRandomStream m_pathsStream;
+	bool m_generated;
+	DungeonGenerationProgress * m_progress;
+	FDungeonGenerationOptions m_options;
+
+	static const int m_SOLVE_BAND_ROWS = 16;
+	static const int m_EROSION_BAND_ROWS = 16;
+	static const int m_PATH_BATCH_NODES = 64;
+	static const int m_MINIMUM_CHUNK_SIZE = 16;
 };
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "DungeonRandom.h"
+
+/**********************************************************************************************************
+*	static uint32 Hash(uint32 Value)
+*		Purpose:	Integer hash with good avalanche. Flipping any bit of Value flips about half the bits
+*					of the result. This is the 32 bit finalizer from MurmurHash3.
+*
+*		Parameters:
+*			uint32 Value
+*				The value to hash.
+*
+*		Return:		The hashed value.
+**********************************************************************************************************/
+uint32 DungeonRandom::Hash(uint32 Value)
+{
+	Value ^= Value >> 16;
+	Value *= 0x85EBCA6BU;
+	Value ^= Value >> 13;
+	Value *= 0xC2B2AE35U;
+	Value ^= Value >> 16;
+
+	return Value;
+}
+/**********************************************************************************************************
+*	static uint32 HashTile(int32 Seed, int32 Pass, int32 X, int32 Y)
+*		Purpose:	Makes the random number for a tile. Each input is folded into the hash in turn, so
+*					swapping X and Y or moving to the next pass gives an unrelated number.
+*
+*		Parameters:
+*			int32 Seed
+*				The seed of the dungeon.
+*			int32 Pass
+*				Which pass of the generation step the number is for.
+*			int32 X, int32 Y
+*				The tile the number is for, in layout coordinates.
+*
+*		Return:		The random number.
+**********************************************************************************************************/
+uint32 DungeonRandom::HashTile(int32 Seed, int32 Pass, int32 X, int32 Y)
+{
+	uint32 hashed = Hash((uint32)Seed ^ 0x9E3779B9U);
+
+	hashed = Hash(hashed ^ (uint32)Pass);
+	hashed = Hash(hashed ^ (uint32)X);
+	hashed = Hash(hashed ^ (uint32)Y);
+
+	return hashed;
+}
+/**********************************************************************************************************
+*	static float ToFraction(uint32 Hashed)
+*		Purpose:	Uses the top 24 bits of a hash as a fraction. 24 bits is all a float can hold
+*					exactly, so every result is equally likely and 1 is never returned.
+*
+*		Parameters:
+*			uint32 Hashed
+*				A hash from Hash or HashTile.
+*
+*		Return:		A float in the range [0, 1).
+**********************************************************************************************************/
+float DungeonRandom::ToFraction(uint32 Hashed)
+{
+	return (float)(Hashed >> 8) * (1.0f / 16777216.0f);
+}
+/**********************************************************************************************************
+*	static FRandomStream DeriveStream(int32 ParentSeed, int32 ChildIndex)
+*		Purpose:	Makes a stream for a child from its parent's seed. The child's seed is a hash of both,
+*					so siblings get unrelated streams and a child's stream does not depend on how many
+*					numbers its parent or siblings drew. Children of the child can be split off of the
+*					child's seed in turn.
+*
+*		Parameters:
+*			int32 ParentSeed
+*				The initial seed of the parent's stream.
+*			int32 ChildIndex
+*				Which child of the parent the stream is for.
+*
+*		Return:		A new stream seeded for the child.
+**********************************************************************************************************/
+FRandomStream DungeonRandom::DeriveStream(int32 ParentSeed, int32 ChildIndex)
+{
+	uint32 childSeed = Hash(Hash((uint32)ParentSeed ^ 0x7F4A7C15U) ^ (uint32)ChildIndex);
+
+	return FRandomStream((int32)childSeed);
+}
+/**********************************************************************************************************
+*	static FRandomStream DeriveNodeStream(int32 Seed, int32 Level, uint64 MortonCode)
+*		Purpose:	Makes a stream for a quad tree node from a seed and the node's place in the tree. Every
+*					node gets an unrelated stream that does not depend on what any other node drew, so
+*					nodes can be worked on in any order.
+*
+*		Parameters:
+*			int32 Seed
+*				The seed of the whole dungeon.
+*			int32 Level
+*				How far below the root the node is.
+*			uint64 MortonCode
+*				The node's Morton code within its level.
+*
+*		Return:		A new stream seeded for the node.
+**********************************************************************************************************/
+FRandomStream DungeonRandom::DeriveNodeStream(int32 Seed, int32 Level, uint64 MortonCode)
+{
+	uint32 nodeSeed = Hash((uint32)Seed ^ 0x2545F491U);
+	nodeSeed = Hash(nodeSeed ^ (uint32)Level);
+	nodeSeed = Hash(nodeSeed ^ (uint32)MortonCode);
+	nodeSeed = Hash(nodeSeed ^ (uint32)(MortonCode >> 32));
+
+	return FRandomStream((int32)nodeSeed);
+}
+/**********************************************************************************************************
+*	static int32 AdvanceSeed(int32 Seed, uint64 Steps)
+*		Purpose:	Skips a stream ahead without drawing from it. FRandomStream steps its seed with
+*					Seed * A + C, so Steps steps are Seed * A^Steps + C * (A^(Steps - 1) + ... + 1). Both
+*					terms are built up by squaring, which takes one loop per bit of Steps. A and C must
+*					match FRandomStream::MutateSeed.
+*
+*		Parameters:
+*			int32 Seed
+*				The current seed of the stream.
+*			uint64 Steps
+*				The number of numbers to skip.
+*
+*		Return:		The seed after Steps numbers. A stream made with it draws what the skipped stream would.
+**********************************************************************************************************/
+int32 DungeonRandom::AdvanceSeed(int32 Seed, uint64 Steps)
+{
+	uint32 multiplier = 196314165U;
+	uint32 increment = 907633515U;
+
+	uint32 totalMultiplier = 1;
+	uint32 totalIncrement = 0;
+
+	while (Steps > 0)
+	{
+		if (Steps & 1)
+		{
+			totalMultiplier *= multiplier;
+			totalIncrement = totalIncrement * multiplier + increment;
+		}
+
+		increment *= multiplier + 1;
+		multiplier *= multiplier;
+		Steps >>= 1;
+	}
+
+	return (int32)((uint32)Seed * totalMultiplier + totalIncrement);
+}
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+/**********************************************************************************************************
+*	Class: DungeonRandom
+*
+*	Overview:
+*		Counter based random numbers for the generation steps. Instead of drawing the next number from a
+*		stream, a number is made by hashing the seed together with where it is used, such as an erosion
+*		pass and a tile. The same inputs always give the same number no matter what was generated before
+*		it, so work can be done in any order, on any thread, or only for part of the dungeon.
+*
+*	Methods:
+*
+*		static uint32 Hash(uint32 Value)
+*			Mixes the bits of Value so that close inputs give unrelated outputs.
+*		static uint32 HashTile(int32 Seed, int32 Pass, int32 X, int32 Y)
+*			Returns the random number for the tile at (X, Y) on the given pass.
+*		static float ToFraction(uint32 Hashed)
+*			Turns a hash into a float in the range [0, 1).
+*		static FRandomStream DeriveStream(int32 ParentSeed, int32 ChildIndex)
+*			Splits a new stream off of a parent seed. Each child index gets an unrelated stream.
+*		static FRandomStream DeriveNodeStream(int32 Seed, int32 Level, uint64 MortonCode)
+*			Makes a stream for the quad tree node at the given place in the tree.
+*		static int32 AdvanceSeed(int32 Seed, uint64 Steps)
+*			Returns the seed a FRandomStream at Seed would have after drawing Steps numbers.
+**********************************************************************************************************/
+class HALVA_API DungeonRandom
+{
+public:
+
+	static uint32 Hash(uint32 Value);
+	static uint32 HashTile(int32 Seed, int32 Pass, int32 X, int32 Y);
+	static float ToFraction(uint32 Hashed);
+	static FRandomStream DeriveStream(int32 ParentSeed, int32 ChildIndex);
+	static FRandomStream DeriveNodeStream(int32 Seed, int32 Level, uint64 MortonCode);
+	static int32 AdvanceSeed(int32 Seed, uint64 Steps);
+};
@@ -0,0 +1,336 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "FloorBitboard.h"
+
+/**********************************************************************************************************
+*	FloorBitboard()
+*		Purpose:	Default constructor. Results in a 0x0 board.
+**********************************************************************************************************/
+FloorBitboard::FloorBitboard()
+{
+	m_words = TArray<uint64>();
+	m_width = 0;
+	m_height = 0;
+	m_wordsPerRow = 0;
+}
+/**********************************************************************************************************
+*	FloorBitboard(int Width, int Height)
+*		Purpose:	Constructor. Creates a board of the given size with no floors on it.
+*
+*		Parameters:
+*			int Width
+*				The number of tiles in a row.
+*			int Height
+*				The number of rows.
+**********************************************************************************************************/
+FloorBitboard::FloorBitboard(int Width, int Height)
+{
+	Reset(Width, Height);
+}
+/**********************************************************************************************************
+*	FloorBitboard(TileLayoutView Layout)
+*		Purpose:	Constructor. Creates a board matching the floors of Layout.
+*
+*		Parameters:
+*			TileLayoutView Layout
+*				The layout to read floors from.
+**********************************************************************************************************/
+FloorBitboard::FloorBitboard(TileLayoutView Layout)
+{
+	BuildFromLayout(Layout);
+}
+/**********************************************************************************************************
+*	int GetWidth()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int FloorBitboard::GetWidth() const
+{
+	return m_width;
+}
+/**********************************************************************************************************
+*	int GetHeight()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int FloorBitboard::GetHeight() const
+{
+	return m_height;
+}
+/**********************************************************************************************************
+*	int GetWordsPerRow()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int FloorBitboard::GetWordsPerRow() const
+{
+	return m_wordsPerRow;
+}
+/**********************************************************************************************************
+*	uint64 * GetRow(int Y)
+*		Purpose:	Getter. Returns the first word of row Y.
+**********************************************************************************************************/
+uint64 * FloorBitboard::GetRow(int Y)
+{
+	check(Y >= 0 && Y < m_height);
+	return m_words.GetData() + Y * m_wordsPerRow;
+}
+/**********************************************************************************************************
+*	const uint64 * GetRow(int Y)
+*		Purpose:	Getter. Returns the first word of row Y.
+**********************************************************************************************************/
+const uint64 * FloorBitboard::GetRow(int Y) const
+{
+	check(Y >= 0 && Y < m_height);
+	return m_words.GetData() + Y * m_wordsPerRow;
+}
+/**********************************************************************************************************
+*	void Reset(int Width, int Height)
+*		Purpose:	Resizes the board and clears every bit.
+*
+*		Parameters:
+*			int Width
+*				The number of tiles in a row.
+*			int Height
+*				The number of rows.
+*
+*		Changes:
+*			m_words - Resized and zeroed.
+**********************************************************************************************************/
+void FloorBitboard::Reset(int Width, int Height)
+{
+	m_width = Width > 0 ? Width : 0;
+	m_height = Height > 0 ? Height : 0;
+	m_wordsPerRow = (m_width + 63) / 64;
+
+	m_words.Empty(m_wordsPerRow * m_height);
+	m_words.AddZeroed(m_wordsPerRow * m_height);
+}
+/**********************************************************************************************************
+*	void BuildFromLayout(TileLayoutView Layout)
+*		Purpose:	Resizes the board to the size of Layout and sets the bit of every floor tile.
+*
+*		Parameters:
+*			TileLayoutView Layout
+*				The layout to read floors from.
+*
+*		Changes:
+*			m_words - Holds the floors of Layout.
+**********************************************************************************************************/
+void FloorBitboard::BuildFromLayout(TileLayoutView Layout)
+{
+	Reset(Layout.width, Layout.height);
+
+	for (int y = 0; y < m_height; y++)
+	{
+		const TileData * tiles = Layout.GetRow(y);
+		uint64 * words = GetRow(y);
+
+		for (int x = 0; x < m_width; x++)
+		{
+			if (tiles[x].GetTileType() == TileType::floorTile)
+				words[x >> 6] |= (uint64)1 << (x & 63);
+		}
+	}
+}
+/**********************************************************************************************************
+*	bool IsFloor(int X, int Y)
+*		Purpose:	Checks the bit for the tile at (X, Y).
+*
+*		Return:		True if the tile is a floor. Tiles outside the board are never floors.
+**********************************************************************************************************/
+bool FloorBitboard::IsFloor(int X, int Y) const
+{
+	if (X < 0 || Y < 0 || X >= m_width || Y >= m_height)
+		return false;
+
+	return (m_words[Y * m_wordsPerRow + (X >> 6)] >> (X & 63)) & 1;
+}
+/**********************************************************************************************************
+*	void SetFloor(int X, int Y, bool Floor)
+*		Purpose:	Sets or clears the bit for the tile at (X, Y).
+*
+*		Parameters:
+*			int X, int Y
+*				The tile to change. Must be on the board.
+*			bool Floor
+*				If the tile should be a floor.
+**********************************************************************************************************/
+void FloorBitboard::SetFloor(int X, int Y, bool Floor)
+{
+	check(X >= 0 && Y >= 0 && X < m_width && Y < m_height);
+
+	uint64 & word = m_words[Y * m_wordsPerRow + (X >> 6)];
+	uint64 bit = (uint64)1 << (X & 63);
+
+	if (Floor)
+		word |= bit;
+	else
+		word &= ~bit;
+}
+/**********************************************************************************************************
+*	void SetFloorSpan(int Y, int XStart, int XEnd)
+*		Purpose:	Sets the bits for a run of tiles in one row. Whole words in the middle of the run are
+*					set at once, only the words at either end are masked.
+*
+*		Parameters:
+*			int Y
+*				The row. Must be on the board.
+*			int XStart, int XEnd
+*				The first tile of the run and one past the last. Must be on the board.
+**********************************************************************************************************/
+void FloorBitboard::SetFloorSpan(int Y, int XStart, int XEnd)
+{
+	check(Y >= 0 && Y < m_height && XStart >= 0 && XEnd <= m_width);
+
+	if (XStart >= XEnd)
+		return;
+
+	uint64 * words = GetRow(Y);
+	int firstWord = XStart >> 6;
+	int lastWord = (XEnd - 1) >> 6;
+
+	uint64 firstMask = ~(uint64)0 << (XStart & 63);
+	uint64 lastMask = ~(uint64)0 >> (63 - ((XEnd - 1) & 63));
+
+	if (firstWord == lastWord)
+	{
+		words[firstWord] |= firstMask & lastMask;
+		return;
+	}
+
+	words[firstWord] |= firstMask;
+
+	for (int word = firstWord + 1; word < lastWord; word++)
+		words[word] = ~(uint64)0;
+
+	words[lastWord] |= lastMask;
+}
+/**********************************************************************************************************
+*	uint64 GetWord(int Y, int Word)
+*		Purpose:	Getter. Rows and words outside the board read as all zero so callers do not have to
+*					special case the edges of the board.
+**********************************************************************************************************/
+uint64 FloorBitboard::GetWord(int Y, int Word) const
+{
+	if (Y < 0 || Y >= m_height || Word < 0 || Word >= m_wordsPerRow)
+		return 0;
+
+	return m_words[Y * m_wordsPerRow + Word];
+}
+/**********************************************************************************************************
+*	uint64 GetWestNeighbors(int Y, int Word)
+*		Purpose:	Finds which tiles in a word have a floor immediately to their west (X - 1). The
+*					lowest bit of the word borrows the highest bit of the word before it.
+*
+*		Return:		A word with a bit set for every tile whose western neighbor is a floor.
+**********************************************************************************************************/
+uint64 FloorBitboard::GetWestNeighbors(int Y, int Word) const
+{
+	return (GetWord(Y, Word) << 1) | (GetWord(Y, Word - 1) >> 63);
+}
+/**********************************************************************************************************
+*	uint64 GetEastNeighbors(int Y, int Word)
+*		Purpose:	Finds which tiles in a word have a floor immediately to their east (X + 1). The
+*					highest bit of the word borrows the lowest bit of the word after it.
+*
+*		Return:		A word with a bit set for every tile whose eastern neighbor is a floor.
+**********************************************************************************************************/
+uint64 FloorBitboard::GetEastNeighbors(int Y, int Word) const
+{
+	return (GetWord(Y, Word) >> 1) | (GetWord(Y, Word + 1) << 63);
+}
+/**********************************************************************************************************
+*	uint64 CountOrthogonalNeighbors(int Y, int Word, uint64 & Ones, uint64 & Twos, uint64 & Fours)
+*		Purpose:	Adds up the north, south, west and east neighbor bits of every tile in a word with a bit
+*					sliced adder. Afterwards the number of floors next to the tile at bit B is
+*					Ones + 2 * Twos + 4 * Fours at bit B.
+*
+*		Parameters:
+*			int Y, int Word
+*				The word to count the neighbors of.
+*			uint64 & Ones, uint64 & Twos, uint64 & Fours
+*				Set to the bits of the count.
+*
+*		Return:		A word with a bit set for every tile with at least one floor next to it.
+**********************************************************************************************************/
+uint64 FloorBitboard::CountOrthogonalNeighbors(int Y, int Word, uint64 & Ones, uint64 & Twos, uint64 & Fours) const
+{
+	uint64 north = GetWord(Y + 1, Word);
+	uint64 south = GetWord(Y - 1, Word);
+	uint64 west = GetWestNeighbors(Y, Word);
+	uint64 east = GetEastNeighbors(Y, Word);
+
+	uint64 northSouthSum = north ^ south;
+	uint64 northSouthCarry = north & south;
+	uint64 westEastSum = west ^ east;
+	uint64 westEastCarry = west & east;
+	uint64 onesCarry = northSouthSum & westEastSum;
+
+	Ones = northSouthSum ^ westEastSum;
+	Twos = northSouthCarry ^ westEastCarry ^ onesCarry;
+	Fours = (northSouthCarry & westEastCarry) | ((northSouthCarry | westEastCarry) & onesCarry);
+
+	return north | south | west | east;
+}
+/**********************************************************************************************************
+*	uint64 GetValidBits(int Word)
+*		Purpose:	Finds which bits of a word in any row belong to tiles on the board.
+*
+*		Return:		All ones for every word except possibly the last in the row.
+**********************************************************************************************************/
+uint64 FloorBitboard::GetValidBits(int Word) const
+{
+	int remaining = m_width - Word * 64;
+
+	if (remaining >= 64)
+		return ~(uint64)0;
+	if (remaining <= 0)
+		return 0;
+
+	return ((uint64)1 << remaining) - 1;
+}
+/**********************************************************************************************************
+*	int CountFloors()
+*		Purpose:	Counts every floor on the board.
+*
+*		Return:		The number of set bits.
+**********************************************************************************************************/
+int FloorBitboard::CountFloors() const
+{
+	int floors = 0;
+
+	for (int i = 0; i < m_words.Num(); i++)
+		floors += PopCount(m_words[i]);
+
+	return floors;
+}
+/**********************************************************************************************************
+*	static int PopCount(uint64 Bits)
+*		Purpose:	Counts the set bits of a word with a branch free bit twiddle.
+*
+*		Return:		The number of bits set in Bits.
+**********************************************************************************************************/
+int FloorBitboard::PopCount(uint64 Bits)
+{
+	Bits = Bits - ((Bits >> 1) & 0x5555555555555555ULL);
+	Bits = (Bits & 0x3333333333333333ULL) + ((Bits >> 2) & 0x3333333333333333ULL);
+	Bits = (Bits + (Bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+
+	return (int)((Bits * 0x0101010101010101ULL) >> 56);
+}
+/**********************************************************************************************************
+*	static int CountTrailingZeros(uint64 Bits)
+*		Purpose:	Finds the lowest set bit of a word. Used to walk only the set bits of a word.
+*
+*		Return:		The index of the lowest set bit. Bits must not be 0.
+**********************************************************************************************************/
+int FloorBitboard::CountTrailingZeros(uint64 Bits)
+{
+	check(Bits != 0);
+
+	uint32 low = (uint32)Bits;
+
+	if (low != 0)
+		return FMath::CountTrailingZeros(low);
+
+	return 32 + FMath::CountTrailingZeros((uint32)(Bits >> 32));
+}
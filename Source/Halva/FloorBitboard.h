@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "TileStructure.h"
+/**********************************************************************************************************
+*	Class: FloorBitboard
+*
+*	Overview:
+*		A one bit per tile copy of which tiles in a layout are floors. Each row is stored as a run of
+*		64 bit words where bit B of word W is the tile at X = W * 64 + B. Neighborhood questions such as
+*		"which tiles have a floor to the west" can then be answered for 64 tiles with a couple of shifts
+*		instead of one tile at a time. Tiles outside the board are never floors.
+*
+*	Manager Functions:
+*
+*		FloorBitboard();
+*			Default constructor. Results in a 0x0 board.
+*		FloorBitboard(int Width, int Height);
+*			Creates a board of the given size with no floors.
+*		FloorBitboard(TileLayoutView Layout);
+*			Creates a board the size of Layout with a bit set for each floor tile in it.
+*
+*	Mutators:
+*
+*		Width
+*			-Get
+*		Height
+*			-Get
+*		WordsPerRow
+*			-Get
+*		Row
+*			-Get
+*
+*	Methods:
+*
+*		void Reset(int Width, int Height)
+*			Resizes the board and clears every bit.
+*		void BuildFromLayout(TileLayoutView Layout)
+*			Resizes the board to match Layout and sets a bit for each floor tile.
+*		bool IsFloor(int X, int Y)
+*			Returns if the tile at (X, Y) is a floor. Out of range tiles are not floors.
+*		void SetFloor(int X, int Y, bool Floor)
+*			Sets or clears the bit for the tile at (X, Y).
+*		void SetFloorSpan(int Y, int XStart, int XEnd)
+*			Sets the bits for the tiles in row Y from XStart up to XEnd, a word at a time.
+*		uint64 GetWord(int Y, int Word)
+*			Returns a word of row Y. Rows outside the board read as all zero.
+*		uint64 GetWestNeighbors(int Y, int Word)
+*			Returns a word with a bit set for each tile whose western neighbor is a floor.
+*		uint64 GetEastNeighbors(int Y, int Word)
+*			Returns a word with a bit set for each tile whose eastern neighbor is a floor.
+*		uint64 CountOrthogonalNeighbors(int Y, int Word, uint64 & Ones, uint64 & Twos, uint64 & Fours)
+*			Counts the floors north, south, east and west of every tile in a word at once.
+*		uint64 GetValidBits(int Word)
+*			Returns the bits of a word that are inside the board. Only the last word in a row can have
+*			bits outside the board.
+*		int CountFloors()
+*			Counts every floor on the board.
+*		static int PopCount(uint64 Bits)
+*			Counts the set bits in Bits.
+*		static int CountTrailingZeros(uint64 Bits)
+*			Returns the index of the lowest set bit in Bits. Bits must not be 0.
+*
+*	Data Members:
+*
+*		TArray<uint64> m_words
+*			The rows of the board back to back, m_wordsPerRow words per row.
+*		int m_width
+*			The number of tiles in a row.
+*		int m_height
+*			The number of rows.
+*		int m_wordsPerRow
+*			The number of words needed to hold a row.
+**********************************************************************************************************/
+class HALVA_API FloorBitboard
+{
+public:
+
+	FloorBitboard();
+	FloorBitboard(int Width, int Height);
+	FloorBitboard(TileLayoutView Layout);
+
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetWordsPerRow() const;
+	uint64 * GetRow(int Y);
+	const uint64 * GetRow(int Y) const;
+
+	void Reset(int Width, int Height);
+	void BuildFromLayout(TileLayoutView Layout);
+	bool IsFloor(int X, int Y) const;
+	void SetFloor(int X, int Y, bool Floor);
+	void SetFloorSpan(int Y, int XStart, int XEnd);
+	uint64 GetWord(int Y, int Word) const;
+	uint64 GetWestNeighbors(int Y, int Word) const;
+	uint64 GetEastNeighbors(int Y, int Word) const;
+	uint64 CountOrthogonalNeighbors(int Y, int Word, uint64 & Ones, uint64 & Twos, uint64 & Fours) const;
+	uint64 GetValidBits(int Word) const;
+	int CountFloors() const;
+
+	static int PopCount(uint64 Bits);
+	static int CountTrailingZeros(uint64 Bits);
+
+private:
+
+	TArray<uint64> m_words;
+	int m_width;
+	int m_height;
+	int m_wordsPerRow;
+};
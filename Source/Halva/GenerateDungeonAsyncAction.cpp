@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "GenerateDungeonAsyncAction.h"
+
+/**********************************************************************************************************
+*	UGenerateDungeonAsyncAction * GenerateDungeon(AProceduralDungeon * Dungeon)
+*		Purpose:	Makes the node for Dungeon. The node is kept alive by the dungeon's game instance
+*					until it finishes.
+*
+*		Parameters:
+*			AProceduralDungeon * Dungeon
+*				The dungeon to generate from its current properties.
+*
+*		Return:		The node.
+**********************************************************************************************************/
+UGenerateDungeonAsyncAction * UGenerateDungeonAsyncAction::GenerateDungeon(AProceduralDungeon * Dungeon)
+{
+	UGenerateDungeonAsyncAction * action = NewObject<UGenerateDungeonAsyncAction>();
+
+	action->m_dungeon = Dungeon;
+
+	if (Dungeon != nullptr)
+		action->RegisterWithGameInstance(Dungeon);
+
+	return action;
+}
+/**********************************************************************************************************
+*	void Activate()
+*		Purpose:	Starts generating the dungeon in the background. Fires cancelled right away if the
+*					dungeon is gone.
+**********************************************************************************************************/
+void UGenerateDungeonAsyncAction::Activate()
+{
+	if (!m_dungeon.IsValid())
+	{
+		Finish(false);
+		return;
+	}
+
+	TWeakObjectPtr<UGenerateDungeonAsyncAction> weakThis = this;
+
+	m_dungeon->GenerateTilesAsync([weakThis](bool Completed)
+	{
+		if (weakThis.IsValid())
+			weakThis->Finish(Completed);
+	});
+}
+/**********************************************************************************************************
+*	void Finish(bool Completed)
+*		Purpose:	Fires the output pin for how the generation ended.
+*
+*		Parameters:
+*			bool Completed
+*				True if the tiles were built.
+*
+*		Changes:
+*			The node is marked ready to be destroyed.
+**********************************************************************************************************/
+void UGenerateDungeonAsyncAction::Finish(bool Completed)
+{
+	if (Completed)
+		completed.Broadcast();
+	else
+		cancelled.Broadcast();
+
+	SetReadyToDestroy();
+}
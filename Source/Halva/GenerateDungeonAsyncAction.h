@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "ProceduralDungeon.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "GenerateDungeonAsyncAction.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FGenerateDungeonOutputPin);
+
+/**********************************************************************************************************
+*	Class: GenerateDungeonAsyncAction
+*
+*	Overview:
+*		The "Generate Dungeon" Blueprint node. Starts AProceduralDungeon::GenerateTilesAsync and fires
+*		one of its output pins on the game thread once the generation is done. Completed fires once the
+*		tiles have been built, Cancelled fires if the generation was cancelled, replaced by another
+*		generation or the dungeon was destroyed.
+*
+*	Methods:
+*
+*		GenerateDungeon(AProceduralDungeon * Dungeon)
+*			Makes the node. Generation starts when the node is activated.
+*		Activate()
+*			Starts generating the dungeon.
+*		Finish(bool Completed)
+*			Fires the output pin for how the generation ended and lets the node be destroyed.
+*
+*	Data Members:
+*
+*		FGenerateDungeonOutputPin completed
+*			Fired when the tiles have been built.
+*		FGenerateDungeonOutputPin cancelled
+*			Fired when the generation ended without building the tiles.
+*		TWeakObjectPtr<AProceduralDungeon> m_dungeon
+*			The dungeon to generate.
+**********************************************************************************************************/
+UCLASS()
+class HALVA_API UGenerateDungeonAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+
+	UFUNCTION(BlueprintCallable, Category = "DungeonLayout", meta = (BlueprintInternalUseOnly = "true"))
+		static UGenerateDungeonAsyncAction * GenerateDungeon(AProceduralDungeon * Dungeon);
+
+	virtual void Activate() override;
+
+	UPROPERTY(BlueprintAssignable)
+		FGenerateDungeonOutputPin completed;
+	UPROPERTY(BlueprintAssignable)
+		FGenerateDungeonOutputPin cancelled;
+
+protected:
+
+	void Finish(bool Completed);
+
+	TWeakObjectPtr<AProceduralDungeon> m_dungeon;
+
+};
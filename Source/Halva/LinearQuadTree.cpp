@@ -0,0 +1,298 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "LinearQuadTree.h"
+
+/**********************************************************************************************************
+*	LinearQuadTree()
+*		Purpose:	Default constructor. Results in an empty tree.
+**********************************************************************************************************/
+LinearQuadTree::LinearQuadTree()
+{
+	m_nodes = TArray<LinearQuadTreeNode>();
+	m_leaves = TArray<int>();
+}
+/**********************************************************************************************************
+*	LinearQuadTree(QuadTreeNode * Root)
+*		Purpose:	Constructor. Flattens the tree under Root.
+*
+*		Parameters:
+*			QuadTreeNode * Root
+*				The root of the tree to flatten.
+**********************************************************************************************************/
+LinearQuadTree::LinearQuadTree(QuadTreeNode * Root)
+{
+	Build(Root);
+}
+/**********************************************************************************************************
+*	LinearQuadTreeNode & GetNode(int Index)
+*		Purpose:	Getter.
+**********************************************************************************************************/
+LinearQuadTreeNode & LinearQuadTree::GetNode(int Index)
+{
+	return m_nodes[Index];
+}
+/**********************************************************************************************************
+*	const LinearQuadTreeNode & GetNode(int Index)
+*		Purpose:	Getter.
+**********************************************************************************************************/
+const LinearQuadTreeNode & LinearQuadTree::GetNode(int Index) const
+{
+	return m_nodes[Index];
+}
+/**********************************************************************************************************
+*	LinearQuadTreeNode & GetLeaf(int LeafIndex)
+*		Purpose:	Getter. Returns the LeafIndex'th leaf in depth first order.
+**********************************************************************************************************/
+LinearQuadTreeNode & LinearQuadTree::GetLeaf(int LeafIndex)
+{
+	return m_nodes[m_leaves[LeafIndex]];
+}
+/**********************************************************************************************************
+*	const LinearQuadTreeNode & GetLeaf(int LeafIndex)
+*		Purpose:	Getter. Returns the LeafIndex'th leaf in depth first order.
+**********************************************************************************************************/
+const LinearQuadTreeNode & LinearQuadTree::GetLeaf(int LeafIndex) const
+{
+	return m_nodes[m_leaves[LeafIndex]];
+}
+/**********************************************************************************************************
+*	void Build(QuadTreeNode * Root)
+*		Purpose:	Flattens the tree under Root, replacing anything already in this tree. The rooms in
+*					the flattened nodes are copied from the tree.
+*
+*		Parameters:
+*			QuadTreeNode * Root
+*				The root of the tree to flatten. If nullptr the tree is left empty.
+*
+*		Changes:
+*			m_nodes - Holds every node under Root depth first.
+*			m_leaves - Holds the index of every leaf depth first.
+**********************************************************************************************************/
+void LinearQuadTree::Build(QuadTreeNode * Root)
+{
+	m_nodes.Empty();
+	m_leaves.Empty();
+
+	if (Root != nullptr)
+		AddNodeRecursive(Root, -1, 0, 0);
+
+	RefreshRoomBounds();
+}
+/**********************************************************************************************************
+*	int Num()
+*		Purpose:	Getter. The number of nodes in the tree.
+**********************************************************************************************************/
+int LinearQuadTree::Num() const
+{
+	return m_nodes.Num();
+}
+/**********************************************************************************************************
+*	int NumLeaves()
+*		Purpose:	Getter. The number of leaves in the tree.
+**********************************************************************************************************/
+int LinearQuadTree::NumLeaves() const
+{
+	return m_leaves.Num();
+}
+/**********************************************************************************************************
+*	int NumRooms()
+*		Purpose:	Getter. The number of leaves with a room. The root's room count is kept up to date
+*					by SetRoom and RefreshRoomBounds, so this does not walk the tree.
+**********************************************************************************************************/
+int LinearQuadTree::NumRooms() const
+{
+	if (m_nodes.Num() == 0)
+		return 0;
+
+	return m_nodes[0].roomCount;
+}
+/**********************************************************************************************************
+*	void SetRoom(int NodeIndex, Quad Room)
+*		Purpose:	Sets the room of a leaf and walks up to the root refreshing the cached room bounds on
+*					the way. This costs one step per level.
+*
+*		Parameters:
+*			int NodeIndex
+*				The index of the leaf.
+*			Quad Room
+*				The new room. A room with 0 bounds removes the leaf's room.
+*
+*		Changes:
+*			m_nodes - The leaf's room and the room bounds of the nodes above it are updated.
+**********************************************************************************************************/
+void LinearQuadTree::SetRoom(int NodeIndex, Quad Room)
+{
+	check(m_nodes[NodeIndex].IsLeaf());
+
+	m_nodes[NodeIndex].room = Room;
+
+	for (int node = NodeIndex; node >= 0; node = m_nodes[node].parent)
+		RefreshNode(node);
+}
+/**********************************************************************************************************
+*	void RefreshRoomBounds()
+*		Purpose:	Recomputes the cached room bounds of every node. Children are always stored after
+*					their parent, so walking the array backwards finishes every child before its parent.
+*
+*		Changes:
+*			m_nodes - Every node's roomBounds and roomCount are updated.
+**********************************************************************************************************/
+void LinearQuadTree::RefreshRoomBounds()
+{
+	for (int i = m_nodes.Num() - 1; i >= 0; i--)
+		RefreshNode(i);
+}
+/**********************************************************************************************************
+*	float GetRoomBoundsDistanceSquared(int NodeIndex, FVector Point)
+*		Purpose:	Finds how far Point is from the cached room bounds of a node. No room below the node
+*					can be closer than this, so it is a lower bound for any search under the node.
+*
+*		Parameters:
+*			int NodeIndex
+*				The index of the node.
+*			FVector Point
+*				The point to measure from.
+*
+*		Return:		The squared distance on the X and Y axes. 0 if Point is inside the bounds, the
+*					largest float if there are no rooms below the node.
+**********************************************************************************************************/
+float LinearQuadTree::GetRoomBoundsDistanceSquared(int NodeIndex, FVector Point) const
+{
+	const LinearQuadTreeNode & node = m_nodes[NodeIndex];
+
+	if (node.roomCount == 0)
+		return MAX_flt;
+
+	FVector minimum = node.roomBounds.GetPosition();
+	FVector maximum = node.roomBounds.GetBounds();
+
+	float xDistance = FMath::Max(0.0f, FMath::Max(minimum.X - Point.X, Point.X - maximum.X));
+	float yDistance = FMath::Max(0.0f, FMath::Max(minimum.Y - Point.Y, Point.Y - maximum.Y));
+
+	return xDistance * xDistance + yDistance * yDistance;
+}
+/**********************************************************************************************************
+*	static int GetMortonQuadrant(int Child)
+*		Purpose:	Converts a QuadTreeNode child slot to its Morton quadrant. The slots go SW, NW, NE, SE
+*					while Morton quadrants put X in the low bit and Y in the high bit.
+*
+*		Parameters:
+*			int Child
+*				The child slot, 0 to 3.
+*
+*		Return:		The Morton quadrant, 0 to 3.
+**********************************************************************************************************/
+int LinearQuadTree::GetMortonQuadrant(int Child)
+{
+	static const int MORTON_QUADRANTS[4] = { 0, 2, 3, 1 };
+
+	return MORTON_QUADRANTS[Child];
+}
+/**********************************************************************************************************
+*	int AddNodeRecursive(QuadTreeNode * Node, int Parent, int Level, uint64 MortonCode)
+*		Purpose:	Appends Node and then its subtree, depth first. Only used while building.
+*
+*		Parameters:
+*			QuadTreeNode * Node
+*				The node to add.
+*			int Parent
+*				The index of Node's parent, -1 for the root.
+*			int Level, uint64 MortonCode
+*				Node's location in the tree.
+*
+*		Changes:
+*			m_nodes - Node and its subtree are appended.
+*			m_leaves - Every leaf in the subtree is appended.
+*
+*		Return:		The index Node was added at.
+**********************************************************************************************************/
+int LinearQuadTree::AddNodeRecursive(QuadTreeNode * Node, int Parent, int Level, uint64 MortonCode)
+{
+	int index = m_nodes.AddDefaulted();
+
+	LinearQuadTreeNode & node = m_nodes[index];
+	node.quad = Node->GetQuad();
+	node.room = Node->GetRoom();
+	node.stream = Node->GetRandomStream();
+	node.mortonCode = MortonCode;
+	node.level = Level;
+	node.parent = Parent;
+	node.firstLeaf = m_leaves.Num();
+
+	for (int i = 0; i < 4; i++)
+		node.children[i] = -1;
+
+	QuadTreeNode ** children = Node->GetChildren();
+
+	// If this node has children. m_nodes can grow while adding them so only refer to it by index.
+	if (children != nullptr && children[0] != nullptr)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			int child = AddNodeRecursive(children[i], index, Level + 1, (MortonCode << 2) | GetMortonQuadrant(i));
+			m_nodes[index].children[i] = child;
+		}
+	}
+	else
+		m_leaves.Add(index);
+
+	m_nodes[index].subtreeEnd = m_nodes.Num();
+	m_nodes[index].endLeaf = m_leaves.Num();
+
+	return index;
+}
+/**********************************************************************************************************
+*	void RefreshNode(int Index)
+*		Purpose:	Recomputes the cached room bounds of one node. A leaf uses its own room, a branch
+*					merges the bounds of its children, so the children must already be current.
+*
+*		Parameters:
+*			int Index
+*				The index of the node.
+*
+*		Changes:
+*			m_nodes - The node's roomBounds and roomCount are updated.
+**********************************************************************************************************/
+void LinearQuadTree::RefreshNode(int Index)
+{
+	LinearQuadTreeNode & node = m_nodes[Index];
+
+	if (node.IsLeaf())
+	{
+		node.roomCount = node.HasRoom() ? 1 : 0;
+		node.roomBounds = node.room;
+		return;
+	}
+
+	node.roomCount = 0;
+
+	FVector minimum = FVector(0, 0, 0);
+	FVector maximum = FVector(0, 0, 0);
+
+	for (int i = 0; i < 4; i++)
+	{
+		const LinearQuadTreeNode & child = m_nodes[node.children[i]];
+
+		if (child.roomCount == 0)
+			continue;
+
+		FVector childMinimum = child.roomBounds.GetPosition();
+		FVector childMaximum = child.roomBounds.GetBounds();
+
+		if (node.roomCount == 0)
+		{
+			minimum = childMinimum;
+			maximum = childMaximum;
+		}
+		else
+		{
+			minimum = FVector(FMath::Min(minimum.X, childMinimum.X), FMath::Min(minimum.Y, childMinimum.Y), 0);
+			maximum = FVector(FMath::Max(maximum.X, childMaximum.X), FMath::Max(maximum.Y, childMaximum.Y), 0);
+		}
+
+		node.roomCount += child.roomCount;
+	}
+
+	node.roomBounds = Quad(maximum, minimum);
+}
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "QuadTreeNode.h"
+/**********************************************************************************************************
+*	struct LinearQuadTreeNode
+*
+*		Purpose:
+*			One node of a LinearQuadTree. Nodes refer to each other by index into the tree's node array
+*			instead of by pointer.
+*
+*		Members:
+*			Quad quad
+*				The space that makes up this node.
+*			Quad room
+*				The room in this node. Only used by leaves, a room with 0 bounds means there is no room.
+*			FRandomStream stream
+*				The stream the node was built with.
+*			uint64 mortonCode
+*				The node's position in its level. Each level down appends the 2 bit Morton quadrant of
+*				the child, X in the low bit and Y in the high bit.
+*			int level
+*				How far below the root the node is. The root is level 0.
+*			int parent
+*				The index of the parent node, -1 for the root.
+*			int children[4]
+*				The indices of the children in QuadTreeNode order: 0 = SW, 1 = NW, 2 = NE, 3 = SE. -1 for
+*				leaves.
+*			int subtreeEnd
+*				One past the index of the last node in this node's subtree. The subtree is every node
+*				from this one up to subtreeEnd.
+*			int firstLeaf, int endLeaf
+*				The range of the tree's leaf list that holds the leaves of this subtree.
+*			Quad roomBounds
+*				The smallest quad holding every room in this subtree. Only valid if roomCount is above 0.
+*			int roomCount
+*				The number of rooms in this subtree.
+**********************************************************************************************************/
+struct LinearQuadTreeNode
+{
+	Quad quad;
+	Quad room;
+	FRandomStream stream;
+	uint64 mortonCode;
+	int level;
+	int parent;
+	int children[4];
+	int subtreeEnd;
+	int firstLeaf;
+	int endLeaf;
+	Quad roomBounds;
+	int roomCount;
+
+	bool IsLeaf() const
+	{
+		return children[0] < 0;
+	}
+
+	bool HasRoom() const
+	{
+		return room.GetBounds() != FVector(0, 0, 0);
+	}
+};
+/**********************************************************************************************************
+*	Class: LinearQuadTree
+*
+*	Overview:
+*		A quad tree flattened into one array. Nodes are stored depth first, in the same child order the
+*		QuadTreeNode tree is walked in, so every subtree is one contiguous run of the array starting at
+*		its root. The leaves are also listed on their own in the same order, which makes the leaves of
+*		any subtree one contiguous run of the leaf list. Walking the tree is then a loop over an array
+*		rather than a chain of recursive calls and pointer loads, and the rooms below any node are an
+*		O(1) slice.
+*
+*		Each node also keeps its level and Morton code, which give it a location in the tree that does
+*		not depend on how the array is laid out.
+*
+*		Each node also caches the bounding box and number of the rooms below it. Rooms should be set with
+*		SetRoom, or RefreshRoomBounds called after setting them directly, to keep the cache current. The
+*		boxes let a search skip any subtree that cannot hold anything closer than what it already has.
+*
+*	Manager Functions:
+*
+*		LinearQuadTree();
+*			Default constructor. Results in an empty tree.
+*		LinearQuadTree(QuadTreeNode * Root);
+*			Flattens the tree under Root.
+*
+*	Mutators:
+*
+*		Node
+*			-Get
+*		Leaf
+*			-Get
+*
+*	Methods:
+*
+*		void Build(QuadTreeNode * Root)
+*			Replaces the contents with the flattened tree under Root.
+*		int Num()
+*			Returns the number of nodes.
+*		int NumLeaves()
+*			Returns the number of leaves.
+*		int NumRooms()
+*			Returns the number of leaves with a room, read from the root's cached room count.
+*		void SetRoom(int NodeIndex, Quad Room)
+*			Sets the room of a leaf and updates the cached room bounds of every node above it.
+*		void RefreshRoomBounds()
+*			Recomputes the cached room bounds of every node.
+*		float GetRoomBoundsDistanceSquared(int NodeIndex, FVector Point)
+*			Returns the squared distance from Point to the nearest point of a node's room bounds.
+*		static int GetMortonQuadrant(int Child)
+*			Returns the Morton quadrant of child slot Child.
+*		void RefreshNode(int Index)
+*			Recomputes the cached room bounds of one node from its room or its children.
+*
+*	Data Members:
+*
+*		TArray<LinearQuadTreeNode> m_nodes
+*			Every node, depth first. The root is at index 0.
+*		TArray<int> m_leaves
+*			The index of every leaf node, depth first.
+**********************************************************************************************************/
+class HALVA_API LinearQuadTree
+{
+public:
+
+	LinearQuadTree();
+	LinearQuadTree(QuadTreeNode * Root);
+
+	LinearQuadTreeNode & GetNode(int Index);
+	const LinearQuadTreeNode & GetNode(int Index) const;
+	LinearQuadTreeNode & GetLeaf(int LeafIndex);
+	const LinearQuadTreeNode & GetLeaf(int LeafIndex) const;
+
+	void Build(QuadTreeNode * Root);
+	int Num() const;
+	int NumLeaves() const;
+	int NumRooms() const;
+	void SetRoom(int NodeIndex, Quad Room);
+	void RefreshRoomBounds();
+	float GetRoomBoundsDistanceSquared(int NodeIndex, FVector Point) const;
+
+	static int GetMortonQuadrant(int Child);
+
+private:
+
+	int AddNodeRecursive(QuadTreeNode * Node, int Parent, int Level, uint64 MortonCode);
+	void RefreshNode(int Index);
+
+	TArray<LinearQuadTreeNode> m_nodes;
+	TArray<int> m_leaves;
+};
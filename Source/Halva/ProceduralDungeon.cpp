@@ -2,6 +2,43 @@
 
 #include "Halva.h"
 #include "ProceduralDungeon.h"
+#include "Async/Async.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+
+DECLARE_STATS_GROUP(TEXT("ProceduralDungeon"), STATGROUP_ProceduralDungeon, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tile Instances"), STAT_DungeonTileInstances, STATGROUP_ProceduralDungeon);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Submitted Tile Instances"), STAT_DungeonSubmittedTileInstances, STATGROUP_ProceduralDungeon);
+
+/**********************************************************************************************************
+*	Struct: DungeonGenerationJob
+*
+*	Overview:
+*		A layout being generated in the background along with the properties it is generated from. The
+*		properties are copied when the job starts so the actor can be edited while it runs. Only the
+*		worker touches the layout until the job is handed back to the game thread.
+**********************************************************************************************************/
+struct DungeonGenerationJob
+{
+	DungeonGenerationJob()
+		: progress(MakeShareable(new DungeonGenerationProgress()))
+	{
+		stage = EDungeonStage::None;
+	}
+
+	DungeonLayout layout;
+	EDungeonStage stage;
+	TSharedRef<DungeonGenerationProgress, ESPMode::ThreadSafe> progress;
+	TFunction<void(bool)> onFinished;
+
+	FVector dungeonSize;
+	FVector smallestRoomSize;
+	int desiredRooms;
+	int pathWidth;
+	int erosionPasses;
+	float erosionChance;
+	FRandomStream randomStream;
+	FDungeonGenerationOptions generationOptions;
+};
 
 /**********************************************************************************************************
 *	DungeonLayout()
@@ -22,6 +59,22 @@ AProceduralDungeon::AProceduralDungeon()
 	tileDimensions = FVector(10, 10, 0);
 	erosionPasses = 0;
 	erosionChance = 0;
+	bGenerateAsync = false;
+	instanceBudgetMilliseconds = 0;
+	bHierarchicalInstances = false;
+	tileChunkSize = 16;
+	bPreviewWhileEditing = true;
+	previewSettleTime = 0.5f;
+	m_builtTileDimensions = tileDimensions;
+	m_builtHierarchical = bHierarchicalInstances;
+	m_builtTileChunkSize = tileChunkSize;
+	m_propertyChangePending = false;
+	m_previewShown = false;
+	m_nextPendingInstance = 0;
+	m_deferInstances = false;
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> previewCube(TEXT("/Engine/BasicShapes/Cube.Cube"));
+	previewMesh = previewCube.Object;
 }
 
 // Called when the game starts or when spawned
@@ -35,6 +88,20 @@ void AProceduralDungeon::Tick( float DeltaTime )
 {
 	Super::Tick( DeltaTime );
 
+	if (IsMaterializing())
+		ApplyPendingInstances(instanceBudgetMilliseconds);
+
+#if STATS
+	if (FThreadStats::IsCollectingData())
+	{
+		int submitted = 0;
+		int total = 0;
+		CountSubmittedInstances(submitted, total);
+
+		INC_DWORD_STAT_BY(STAT_DungeonSubmittedTileInstances, submitted);
+		INC_DWORD_STAT_BY(STAT_DungeonTileInstances, total);
+	}
+#endif
 }
 void AProceduralDungeon::OnConstruction(const FTransform & Transform)
 {
@@ -42,8 +109,48 @@ void AProceduralDungeon::OnConstruction(const FTransform & Transform)
 
 	m_randomStream = FRandomStream(randomSeed);
 
-	GenerateTiles();
+	if (m_propertyChangePending && previewSettleTime > 0)
+	{
+		GeneratePreview();
+
+		// Setting the timer again drops the wait for the last change, so its build never runs.
+		GetWorldTimerManager().SetTimer(m_previewTimer, this, &AProceduralDungeon::FinishPreview, previewSettleTime, false);
+		return;
+	}
+
+	GetWorldTimerManager().ClearTimer(m_previewTimer);
+
+	if (bGenerateAsync)
+		GenerateTilesAsync();
+	else
+		GenerateTiles();
+}
+// Called when the actor is being destroyed. A generation still running is cancelled so it stops early.
+void AProceduralDungeon::BeginDestroy()
+{
+	CancelGeneration();
+
+	Super::BeginDestroy();
+}
+#if WITH_EDITOR
+/**********************************************************************************************************
+*	void PostEditChangeProperty(FPropertyChangedEvent & PropertyChangedEvent)
+*		Purpose:	Called by the editor after a property is changed, including each step of a drag.
+*					The parent runs OnConstruction, which previews instead of building the tiles while
+*					m_propertyChangePending is set.
+*
+*		Changes:
+*			m_propertyChangePending - Set for the length of the parent's call if previewing is on.
+**********************************************************************************************************/
+void AProceduralDungeon::PostEditChangeProperty(FPropertyChangedEvent & PropertyChangedEvent)
+{
+	m_propertyChangePending = bPreviewWhileEditing;
+
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	m_propertyChangePending = false;
 }
+#endif
 /**********************************************************************************************************
 *	void GenerateTiles()
 *		Purpose:	Creates a dungeon layout and places a tile at each location in the layout. The tile
@@ -52,6 +159,11 @@ void AProceduralDungeon::OnConstruction(const FTransform & Transform)
 *					floorTiles could be chosen for that location. If the required tile type has no valid
 *					tile meshes, no mesh is picked.
 *
+*					The layout is kept between calls and only the generation stages depending on a
+*					property that changed are run again, see DungeonLayout::Regenerate. If the layout and
+*					the meshes it is built from are unchanged, the existing tiles are kept as they are.
+*					Any generation running in the background is cancelled first.
+*
 *		Changes:
 *				Assuming that there is at least one tile type for each given tile, a static mesh instance
 *				will be added for each tile on the map. The tile will be a random choice between all tiles
@@ -59,120 +171,1112 @@ void AProceduralDungeon::OnConstruction(const FTransform & Transform)
 **********************************************************************************************************/
 void AProceduralDungeon::GenerateTiles()
 {
-	TArray<USceneComponent*> oldChildren = TArray<USceneComponent*>();
+	CancelGeneration();
 
-	RootComponent->GetChildrenComponents(true, oldChildren);
+	EDungeonStage stage = m_dungeonLayout.Regenerate(dungeonSize, smallestRoomSize, desiredRooms, pathWidth, erosionPasses, erosionChance, m_randomStream, generationOptions);
 
-	for (int i = 0; i < oldChildren.Num(); i++)
+	UpdateTileComponents(stage);
+}
+/**********************************************************************************************************
+*	TSharedRef<DungeonGenerationProgress, ESPMode::ThreadSafe> GenerateTilesAsync(TFunction<void(bool)> OnFinished)
+*		Purpose:	GenerateTiles with the layout generated on a worker thread. The layout is copied into a
+*					job along with the properties, regenerated on the thread pool, and handed back to the
+*					game thread where the tile components are built. Any generation already in progress
+*					is cancelled first. The random stream is reset to randomSeed, as OnConstruction does,
+*					so calling this again with the same properties gives the same dungeon.
+*
+*					The job works on a copy so this actor keeps the last completed layout while it runs.
+*					If the job is cancelled or replaced only the copy is thrown away, and the next
+*					generation still only re-runs the stages whose properties changed.
+*
+*		Parameters:
+*			TFunction<void(bool)> OnFinished
+*				Called on the game thread once the job is done, with true if the tiles were built and
+*				false if the job was cancelled or the actor was destroyed.
+*
+*		Changes:
+*			m_dungeonLayout - Copied into the job, then replaced with the generated layout when it is done.
+*			m_generationJob - Set to the new job.
+*			m_randomStream - Reset to randomSeed.
+*
+*		Return:		The job's progress. Cancelling it cancels the job.
+**********************************************************************************************************/
+TSharedRef<DungeonGenerationProgress, ESPMode::ThreadSafe> AProceduralDungeon::GenerateTilesAsync(TFunction<void(bool)> OnFinished)
+{
+	CancelGeneration();
+
+	m_randomStream = FRandomStream(randomSeed);
+
+	TSharedRef<DungeonGenerationJob, ESPMode::ThreadSafe> job = MakeShareable(new DungeonGenerationJob());
+
+	job->layout = m_dungeonLayout;
+	job->onFinished = OnFinished;
+	job->dungeonSize = dungeonSize;
+	job->smallestRoomSize = smallestRoomSize;
+	job->desiredRooms = desiredRooms;
+	job->pathWidth = pathWidth;
+	job->erosionPasses = erosionPasses;
+	job->erosionChance = erosionChance;
+	job->randomStream = m_randomStream;
+	job->generationOptions = generationOptions;
+
+	m_generationJob = job;
+
+	TWeakObjectPtr<AProceduralDungeon> weakThis = this;
+
+	Async<void>(EAsyncExecution::ThreadPool, [job, weakThis]()
 	{
-		oldChildren[i]->DestroyComponent();
+		job->stage = job->layout.Regenerate(job->dungeonSize, job->smallestRoomSize, job->desiredRooms, job->pathWidth, job->erosionPasses, job->erosionChance, job->randomStream, job->generationOptions, &job->progress.Get());
+
+		// Components can only be made on the game thread.
+		AsyncTask(ENamedThreads::GameThread, [job, weakThis]()
+		{
+			if (weakThis.IsValid())
+			{
+				weakThis->FinishGeneration(job);
+				return;
+			}
+
+			job->progress->SetDone();
+
+			if (job->onFinished)
+				job->onFinished(false);
+		});
+	});
+
+	return job->progress;
+}
+/**********************************************************************************************************
+*	bool SetFloor(int X, int Y, bool Floor)
+*		Purpose:	Queues an edit making one tile a floor or taking its floor away. Nothing changes until
+*					ApplyTileEdits.
+*
+*		Parameters:
+*			int X, int Y
+*				The tile to edit.
+*			bool Floor
+*				True to make the tile a floor, false to make it a wall or empty.
+*
+*		Return:		True if the edit was queued. Sparse and chunked layouts cannot be edited, and neither
+*					can the layout while a generation is in progress, since the generated layout would
+*					replace it.
+**********************************************************************************************************/
+bool AProceduralDungeon::SetFloor(int X, int Y, bool Floor)
+{
+	if (IsGenerating())
+		return false;
+
+	return m_dungeonLayout.SetFloor(X, Y, Floor);
+}
+/**********************************************************************************************************
+*	bool SetFloorRect(int XStart, int YStart, int XEnd, int YEnd, bool Floor)
+*		Purpose:	Queues an edit making a rectangle of tiles floors or taking their floors away. Nothing
+*					changes until ApplyTileEdits.
+*
+*		Parameters:
+*			int XStart, int YStart
+*				The first tile of the rectangle.
+*			int XEnd, int YEnd
+*				The tile past the last tile of the rectangle in each direction.
+*			bool Floor
+*				True to make the tiles floors, false to make them walls or empties.
+*
+*		Return:		True if the edit was queued, see SetFloor.
+**********************************************************************************************************/
+bool AProceduralDungeon::SetFloorRect(int XStart, int YStart, int XEnd, int YEnd, bool Floor)
+{
+	if (IsGenerating())
+		return false;
+
+	return m_dungeonLayout.SetFloorRect(TileRect(XStart, YStart, XEnd, YEnd), Floor);
+}
+/**********************************************************************************************************
+*	void ApplyTileEdits()
+*		Purpose:	Applies the edits queued by SetFloor and SetFloorRect. Only the tiles around the edits
+*					are solved again, and only the chunks holding a tile that changed are rebuilt.
+*
+*		Changes:
+*			m_dungeonLayout - The edits are applied.
+*			m_tileChunks - The chunks with changed tiles are rebuilt.
+**********************************************************************************************************/
+void AProceduralDungeon::ApplyTileEdits()
+{
+	if (!m_dungeonLayout.HasDirtyTiles())
+		return;
+
+	TArray<TileChange> changedTiles;
+	m_dungeonLayout.ResolveDirtyTiles(changedTiles);
+
+	if (changedTiles.Num() > 0)
+		RebuildTileChunks(changedTiles);
+}
+/**********************************************************************************************************
+*	void CancelGeneration()
+*		Purpose:	Cancels the generation in progress. The worker stops at its next check and its copy of
+*					the layout is thrown away when it reaches the game thread, leaving the last completed
+*					layout in place. Does nothing if there is none.
+*
+*		Changes:
+*			m_generationJob - Cancelled and cleared.
+**********************************************************************************************************/
+void AProceduralDungeon::CancelGeneration()
+{
+	if (!m_generationJob.IsValid())
+		return;
+
+	m_generationJob->progress->Cancel();
+	m_generationJob.Reset();
+}
+/**********************************************************************************************************
+*	bool IsGenerating()
+*		Purpose:	Checks if a generation started by GenerateTilesAsync is in progress.
+*
+*		Return:		True until the tiles of the last generation started have been built.
+**********************************************************************************************************/
+bool AProceduralDungeon::IsGenerating() const
+{
+	return m_generationJob.IsValid();
+}
+/**********************************************************************************************************
+*	float GetGenerationProgress()
+*		Purpose:	Getter. How far the generation in progress has got, counted in stages.
+*
+*		Return:		From 0 to 1, or 1 if no generation is in progress.
+**********************************************************************************************************/
+float AProceduralDungeon::GetGenerationProgress() const
+{
+	return m_generationJob.IsValid() ? m_generationJob->progress->GetProgress() : 1.0f;
+}
+/**********************************************************************************************************
+*	void FinishGeneration(TSharedRef<DungeonGenerationJob, ESPMode::ThreadSafe> Job)
+*		Purpose:	Called on the game thread when a job's layout is done. If the job is still the one
+*					in progress its layout is taken and the tile components built. A job that was
+*					cancelled or replaced is thrown away, and m_dungeonLayout keeps the last completed
+*					layout.
+*
+*		Parameters:
+*			TSharedRef<DungeonGenerationJob, ESPMode::ThreadSafe> Job
+*				The job that finished.
+*
+*		Changes:
+*			m_dungeonLayout - Takes the job's layout if it completed.
+*			m_generationJob - Cleared if it was Job.
+*				onDungeonGenerated is broadcast if the tiles were built.
+**********************************************************************************************************/
+void AProceduralDungeon::FinishGeneration(TSharedRef<DungeonGenerationJob, ESPMode::ThreadSafe> Job)
+{
+	bool completed = m_generationJob.Get() == &Job.Get() && !Job->progress->IsCancelled();
+
+	if (completed)
+	{
+		m_generationJob.Reset();
+		m_dungeonLayout = MoveTemp(Job->layout);
+
+		UpdateTileComponents(Job->stage);
 	}
 
+	Job->progress->SetDone();
+
+	if (Job->onFinished)
+		Job->onFinished(completed);
+
+	if (completed)
+		onDungeonGenerated.Broadcast();
+}
+/**********************************************************************************************************
+*	void UpdateTileComponents(EDungeonStage Stage)
+*		Purpose:	Replaces the tile components with new ones built from the layout. Skipped if the
+*					layout did not change, the preview is not showing and the meshes are the same.
+*
+*		Parameters:
+*			EDungeonStage Stage
+*				The first stage the layout re-ran, EDungeonStage::None if it did not change.
+*
+*					If instanceBudgetMilliseconds is above 0 in a game world the instances are queued
+*					and placed by Tick, otherwise they are all added here and onDungeonMaterialized is
+*					broadcast.
+*
+*		Changes:
+*			m_tileChunks - Rebuilt for the layout.
+*			m_previewShown - Set to false.
+*			m_pendingInstances - Holds the instances to place over the next frames if deferred.
+**********************************************************************************************************/
+void AProceduralDungeon::UpdateTileComponents(EDungeonStage Stage)
+{
+	if (Stage == EDungeonStage::None && !m_previewShown && !TileMeshesChanged())
+		return;
+
+	DestroyTileComponents();
+	m_previewShown = false;
+
 	InitializeTileArrays();
 
-	m_dungeonLayout = DungeonLayout(dungeonSize, smallestRoomSize, desiredRooms, pathWidth, erosionPasses, erosionChance, m_randomStream);
+	// Only a game world ticks, so the editor always places every instance at once.
+	m_deferInstances = instanceBudgetMilliseconds > 0 && GetWorld() != nullptr && GetWorld()->IsGameWorld();
 
 	CreateTileMeshes();
+
+	m_deferInstances = false;
+
+	if (IsMaterializing())
+		OrderPendingInstances();
+	else
+		onDungeonMaterialized.Broadcast();
+}
+/**********************************************************************************************************
+*	bool TileMeshesChanged()
+*		Purpose:	Checks if anything the tile meshes are built from, other than the layout, changed
+*					since they were last built.
+*
+*		Return:		True if the tile arrays, the tile dimensions, the kind of component or the chunk size
+*					are different from the last build.
+**********************************************************************************************************/
+bool AProceduralDungeon::TileMeshesChanged()
+{
+	if (tileDimensions != m_builtTileDimensions || bHierarchicalInstances != m_builtHierarchical || tileChunkSize != m_builtTileChunkSize)
+		return true;
+
+	TArray<class UStaticMesh*> tileTypeMeshes[TileType::TileType_MAX];
+	GatherTileTypeMeshes(tileTypeMeshes);
+
+	for (int i = 0; i < TileType::TileType_MAX; i++)
+	{
+		if (tileTypeMeshes[i] != m_TILE_TYPE_CONTAINER[i])
+			return true;
+	}
+
+	return false;
 }
 /**********************************************************************************************************
 *	void InitializeTileArrays()
-*		Purpose:	Clears the tile arrays and initializes them for tile data.
+*		Purpose:	Clears the tile chunks and gathers the meshes of each tile type. The components are
+*					made the first time a chunk needs them, see GetTileMesh.
 *
 *		Changes:
-*			m_tileMeshes
-*				Each type of tile will get an initialized static mesh instance with no
-*				instances.
+*			m_tileChunks - Emptied.
+*			m_TILE_TYPE_CONTAINER - Set to the meshes of each tile type.
 **********************************************************************************************************/
 void AProceduralDungeon::InitializeTileArrays()
 {
-	for (int i = 0; i < TileType::TileType_MAX; i++)
+	m_tileChunks.Empty();
+
+	GatherTileTypeMeshes(m_TILE_TYPE_CONTAINER);
+	m_builtTileDimensions = tileDimensions;
+	m_builtHierarchical = bHierarchicalInstances;
+	m_builtTileChunkSize = tileChunkSize;
+}
+/**********************************************************************************************************
+*	FIntPoint GetTileChunkKey(int X, int Y)
+*		Purpose:	Finds the chunk a tile's instance belongs to.
+*
+*		Parameters:
+*			int X, int Y
+*				The location of the tile in the layout.
+*
+*		Return:		The chunk's coordinates, in chunks.
+**********************************************************************************************************/
+FIntPoint AProceduralDungeon::GetTileChunkKey(int X, int Y) const
+{
+	if (m_builtTileChunkSize <= 0)
+		return FIntPoint(0, 0);
+
+	return FIntPoint(X / m_builtTileChunkSize, Y / m_builtTileChunkSize);
+}
+/**********************************************************************************************************
+*	UInstancedStaticMeshComponent * GetTileMesh(TileMeshChunk & Chunk, int Type, int Variant)
+*		Purpose:	Gets the component a chunk uses for one mesh of a tile type, making it if the chunk has
+*					not used the mesh yet. New components are not registered, see RegisterTileMeshes.
+*
+*		Parameters:
+*			TileMeshChunk & Chunk
+*				The chunk the component is for.
+*			int Type
+*				The tile type.
+*			int Variant
+*				The index of the mesh in the tile type's array. The mesh must not be null.
+*
+*		Changes:
+*			Chunk - Gets its slots for the tile type and the component if they are not there yet.
+*
+*		Return:		The component.
+**********************************************************************************************************/
+UInstancedStaticMeshComponent * AProceduralDungeon::GetTileMesh(TileMeshChunk & Chunk, int Type, int Variant)
+{
+	if (Chunk.meshes[Type].Num() == 0)
 	{
-		m_tileMeshes[i] = TArray<UInstancedStaticMeshComponent *>();
+		Chunk.meshes[Type].Init(nullptr, m_TILE_TYPE_CONTAINER[Type].Num());
+		Chunk.instanceTiles[Type].SetNum(m_TILE_TYPE_CONTAINER[Type].Num());
 	}
 
-	// reformats the parallel arrays into a much more workable format.
-	// NOTE: This is only safe as long as parallel array values never change.
-	m_TILE_TYPE_CONTAINER[TileType::emptyTile] = emptyTiles;
-	m_TILE_TYPE_CONTAINER[TileType::floorTile] = floorTiles;
-	m_TILE_TYPE_CONTAINER[TileType::oneSidedWallTile] = singleWallTiles;
-	m_TILE_TYPE_CONTAINER[TileType::twoSidedWallTile] = doubleWallTiles;
-	m_TILE_TYPE_CONTAINER[TileType::threeSidedWallTile] = tripleWallTiles;
-	m_TILE_TYPE_CONTAINER[TileType::outsideCornerTile] = outsideCornerTiles;
-	m_TILE_TYPE_CONTAINER[TileType::insideSingleCornerTile] = singleInsideCornerTiles;
-	m_TILE_TYPE_CONTAINER[TileType::insideDoubleAdjacentCornerTile] = doubleAdjacentInsideCornerTiles;
-	m_TILE_TYPE_CONTAINER[TileType::insideDoubleOppositeCornerTile] = doubleOppositeInsideCornerTiles;
-	m_TILE_TYPE_CONTAINER[TileType::insideTripleCornerTile] = tripleInsideCornerTiles;
-	m_TILE_TYPE_CONTAINER[TileType::insideQuadraCornerTile] = quadraInsideCornerTiles;
-	m_TILE_TYPE_CONTAINER[TileType::pillarTile] = pillarTiles;
-	m_TILE_TYPE_CONTAINER[TileType::lBendTile] = lBendTiles;
-	m_TILE_TYPE_CONTAINER[TileType::tJuctionTile] = tJunctionTiles;
-	m_TILE_TYPE_CONTAINER[TileType::wallCornerCompositeTile] = wallCornerCompositeTiles;
-	m_TILE_TYPE_CONTAINER[TileType::wallCornerCompositeReversedTile] = wallCornerCompositeReversedTiles;
+	UInstancedStaticMeshComponent *& mesh = Chunk.meshes[Type][Variant];
 
-	for (int i = 0; i < TileType::TileType_MAX; i++)
+	if (mesh != nullptr)
+		return mesh;
+
+	// create container.
+	if (m_builtHierarchical)
+		mesh = NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+	else
+		mesh = NewObject<UInstancedStaticMeshComponent>(this);
+
+	mesh->bCastDynamicShadow = false;
+	mesh->SetStaticMesh(m_TILE_TYPE_CONTAINER[Type][Variant]);
+
+	// Set up container for use.
+	mesh->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	mesh->bGenerateOverlapEvents = true;
+	mesh->SetCollisionObjectType(ECollisionChannel::ECC_WorldStatic);
+
+	return mesh;
+}
+/**********************************************************************************************************
+*	void RebuildTileChunks(const TArray<TileChange> & ChangedTiles)
+*		Purpose:	Replaces the instances of the changed tiles. Only the chunks holding a changed tile
+*					are touched: their components are unregistered, the instances of the changed tiles
+*					are dropped, the new tiles are placed like a build places them and the components are
+*					registered again. Unchanged tiles keep their meshes. Instances still queued to be
+*					placed over several frames are placed first, so every chunk holds all of its tiles.
+*
+*		Parameters:
+*			const TArray<TileChange> & ChangedTiles
+*				The tiles that changed, as reported by DungeonLayout::ResolveDirtyTiles.
+*
+*		Changes:
+*			m_tileChunks - The chunks with changed tiles are rebuilt, and chunks made for new tiles.
+*			m_pendingInstances - Placed and emptied.
+**********************************************************************************************************/
+void AProceduralDungeon::RebuildTileChunks(const TArray<TileChange> & ChangedTiles)
+{
+	if (IsMaterializing())
+		ApplyPendingInstances(MAX_flt);
+
+	TSet<FIntPoint> editedTiles;
+	TSet<FIntPoint> changedChunks;
+
+	for (const TileChange & change : ChangedTiles)
+	{
+		editedTiles.Add(FIntPoint(change.x, change.y));
+		changedChunks.Add(GetTileChunkKey(change.x, change.y));
+	}
+
+	for (const FIntPoint & key : changedChunks)
 	{
-		for (int j = 0; j < m_TILE_TYPE_CONTAINER[i].Num(); j++)
+		TileMeshChunk * chunk = m_tileChunks.Find(key);
+
+		if (chunk == nullptr)
+			continue;
+
+		for (int i = 0; i < TileType::TileType_MAX; i++)
 		{
-			// create container.
-			m_tileMeshes[i].Add(NewObject<UInstancedStaticMeshComponent>(this));
+			for (int j = 0; j < chunk->meshes[i].Num(); j++)
+			{
+				UInstancedStaticMeshComponent * mesh = chunk->meshes[i][j];
 
-			m_tileMeshes[i][j]->bCastDynamicShadow = false;
+				if (mesh == nullptr)
+					continue;
 
-			if (m_TILE_TYPE_CONTAINER[i][j] != nullptr)
-				m_tileMeshes[i][j]->SetStaticMesh(m_TILE_TYPE_CONTAINER[i][j]);
+				TArray<FIntPoint> & tiles = chunk->instanceTiles[i][j];
+				mesh->UnregisterComponent();
 
-			// Set up container for use.
-			m_tileMeshes[i][j]->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
-			m_tileMeshes[i][j]->bGenerateOverlapEvents = true;
-			m_tileMeshes[i][j]->SetCollisionObjectType(ECollisionChannel::ECC_WorldStatic);
-			m_tileMeshes[i][j]->RegisterComponent();
+				// Instance order does not matter, so the last instance fills each gap.
+				for (int k = tiles.Num() - 1; k >= 0; k--)
+				{
+					if (!editedTiles.Contains(tiles[k]))
+						continue;
+
+					mesh->PerInstanceSMData.RemoveAtSwap(k, 1, false);
+					tiles.RemoveAtSwap(k, 1, false);
+				}
+			}
 		}
 	}
+
+	for (const TileChange & change : ChangedTiles)
+		BucketTile(change.newTile, change.x, change.y);
+
+	PlaceTileBuckets();
+
+	for (const FIntPoint & key : changedChunks)
+	{
+		TileMeshChunk * chunk = m_tileChunks.Find(key);
+
+		if (chunk != nullptr)
+			RegisterTileMeshChunk(*chunk);
+	}
+}
+/**********************************************************************************************************
+*	void GatherTileTypeMeshes(TArray<class UStaticMesh*> (&TileTypeMeshes)[TileType::TileType_MAX])
+*		Purpose:	Copies the tile arrays into a container indexed by tile type.
+*
+*		Parameters:
+*			TArray<class UStaticMesh*> (&TileTypeMeshes)[TileType::TileType_MAX]
+*				Set to the meshes of each tile type.
+**********************************************************************************************************/
+void AProceduralDungeon::GatherTileTypeMeshes(TArray<class UStaticMesh*> (&TileTypeMeshes)[TileType::TileType_MAX])
+{
+	// reformats the parallel arrays into a much more workable format.
+	// NOTE: This is only safe as long as parallel array values never change.
+	TileTypeMeshes[TileType::emptyTile] = emptyTiles;
+	TileTypeMeshes[TileType::floorTile] = floorTiles;
+	TileTypeMeshes[TileType::oneSidedWallTile] = singleWallTiles;
+	TileTypeMeshes[TileType::twoSidedWallTile] = doubleWallTiles;
+	TileTypeMeshes[TileType::threeSidedWallTile] = tripleWallTiles;
+	TileTypeMeshes[TileType::outsideCornerTile] = outsideCornerTiles;
+	TileTypeMeshes[TileType::insideSingleCornerTile] = singleInsideCornerTiles;
+	TileTypeMeshes[TileType::insideDoubleAdjacentCornerTile] = doubleAdjacentInsideCornerTiles;
+	TileTypeMeshes[TileType::insideDoubleOppositeCornerTile] = doubleOppositeInsideCornerTiles;
+	TileTypeMeshes[TileType::insideTripleCornerTile] = tripleInsideCornerTiles;
+	TileTypeMeshes[TileType::insideQuadraCornerTile] = quadraInsideCornerTiles;
+	TileTypeMeshes[TileType::pillarTile] = pillarTiles;
+	TileTypeMeshes[TileType::lBendTile] = lBendTiles;
+	TileTypeMeshes[TileType::tJuctionTile] = tJunctionTiles;
+	TileTypeMeshes[TileType::wallCornerCompositeTile] = wallCornerCompositeTiles;
+	TileTypeMeshes[TileType::wallCornerCompositeReversedTile] = wallCornerCompositeReversedTiles;
 }
 /**********************************************************************************************************
 *	void CreateTileMeshes()
-*		Purpose:	Constructs the meshes for the tiles. Iterates through the entire dungeon layout once
-*					for each tile type there is. If a tile is found that should match the type of tile,
-*					a random one is picked from the tile types and a mesh is generated.
+*		Purpose:	Constructs the meshes for the tiles. The layout is walked once and each tile with
+*					meshes for its type is put in its type's bucket, see PlaceTileBuckets. The buckets are
+*					then placed a type at a time, picking a random mesh for each tile, which picks the same
+*					meshes as walking the whole layout once for each tile type.
+*
+*					If the layout is sparse only its runs are walked, in the same order the full grid
+*					would be, so the same meshes are picked. Empty tiles are not in the runs, so they are
+*					only visited if there are empty tile meshes to place.
+*
+*					If the layout is chunked the chunks are visited one at a time instead, see
+*					CreateTileMeshesChunked.
+*
+*					The tile components are registered once every instance has been added, see
+*					RegisterTileMeshes.
 *
 *		Changes:
-*			m_tileMeshes
+*			m_tileChunks
 *				Assuming that there is at least one tile type for each given tile, a static mesh instance
 *				will be added for each tile on the map. The tile will be a random choice between all tiles
 *				of the specified tile type.
 **********************************************************************************************************/
 void AProceduralDungeon::CreateTileMeshes()
 {
-	FVector dungeonDimensions = m_dungeonLayout.GetDungeonDimensions();
-	TileData ** layout = m_dungeonLayout.GetDungeonLayout();
+	if (m_dungeonLayout.IsSparse())
+		CreateTileMeshesSparse();
+	else if (m_dungeonLayout.IsChunked())
+		CreateTileMeshesChunked();
+	else
+	{
+		TileLayoutView layout = m_dungeonLayout.GetDungeonLayout();
+
+		for (int y = 0; y < layout.height; y++)
+		{
+			TileData * row = layout.GetRow(y);
+
+			for (int x = 0; x < layout.width; x++)
+				BucketTile(row[x], x, y);
+		}
+
+		PlaceTileBuckets();
+	}
+
+	RegisterTileMeshes();
+}
+/**********************************************************************************************************
+*	void CreateTileMeshesSparse()
+*		Purpose:	CreateTileMeshes for a sparse layout. Walks the runs of the layout once, and the gaps
+*					between them as empty tiles if there are empty tile meshes.
+*
+*		Changes:
+*			m_tileChunks
+*				A static mesh instance is added for each tile on the map with a mesh for its type.
+**********************************************************************************************************/
+void AProceduralDungeon::CreateTileMeshesSparse()
+{
+	const SparseTileLayout & layout = m_dungeonLayout.GetSparseLayout();
+	bool placeEmpties = m_TILE_TYPE_CONTAINER[TileType::emptyTile].Num() > 0;
+
+	for (int y = 0; y < layout.GetHeight(); y++)
+	{
+		int firstRun = 0;
+		int endRun = 0;
+		layout.GetRowRuns(y, firstRun, endRun);
+
+		// Empties are every tile from the end of one run to the start of the next.
+		int x = 0;
+
+		for (int run = firstRun; run <= endRun; run++)
+		{
+			int gapEnd = run < endRun ? layout.GetRun(run).xStart : layout.GetWidth();
+
+			if (placeEmpties)
+			{
+				for (; x < gapEnd; x++)
+					BucketTile(TileData(emptyTile), x, y);
+			}
+
+			if (run == endRun)
+				break;
 
+			const SparseTileRun & tileRun = layout.GetRun(run);
+			const TileData * tiles = layout.GetRunTiles(run);
+
+			for (int j = 0; j < tileRun.count; j++)
+				BucketTile(tiles[j], tileRun.xStart + j, y);
+
+			x = tileRun.GetXEnd();
+		}
+	}
+
+	PlaceTileBuckets();
+}
+/**********************************************************************************************************
+*	void CreateTileMeshesChunked()
+*		Purpose:	CreateTileMeshes for a chunked layout. Each chunk is made, placed and let go in turn,
+*					so the whole grid is never held. Each chunk is bucketed and placed like a full layout,
+*					so meshes are picked in a different order than an unchunked layout and the chosen
+*					meshes differ for the same seed.
+*
+*		Changes:
+*			m_tileChunks
+*				A static mesh instance is added for each tile on the map with a mesh for its type.
+**********************************************************************************************************/
+void AProceduralDungeon::CreateTileMeshesChunked()
+{
+	for (int chunkY = 0; chunkY < m_dungeonLayout.GetNumChunksY(); chunkY++)
+	{
+		for (int chunkX = 0; chunkX < m_dungeonLayout.GetNumChunksX(); chunkX++)
+		{
+			const DungeonChunk & chunk = m_dungeonLayout.GetChunk(chunkX, chunkY);
+
+			for (int y = chunk.GetOriginY(); y < chunk.GetOriginY() + chunk.GetHeight(); y++)
+			{
+				for (int x = chunk.GetOriginX(); x < chunk.GetOriginX() + chunk.GetWidth(); x++)
+					BucketTile(chunk.GetTile(x, y), x, y);
+			}
+
+			PlaceTileBuckets();
+		}
+	}
+}
+/**********************************************************************************************************
+*	void BucketTile(TileData Tile, int X, int Y)
+*		Purpose:	Adds a tile to the bucket for its type if there are meshes for the type.
+*
+*		Parameters:
+*			TileData Tile
+*				The tile to place.
+*			int X, int Y
+*				The location of the tile in the layout.
+*
+*		Changes:
+*			m_tileBuckets - The tile is added to the end of its type's bucket.
+**********************************************************************************************************/
+void AProceduralDungeon::BucketTile(TileData Tile, int X, int Y)
+{
+	int type = Tile.GetTileType();
+
+	if (m_TILE_TYPE_CONTAINER[type].Num() == 0)
+		return;
+
+	PendingTileInstance bucketed;
+	bucketed.variant = -1;
+	bucketed.tile = Tile;
+	bucketed.x = X;
+	bucketed.y = Y;
+
+	m_tileBuckets[type].Add(bucketed);
+}
+/**********************************************************************************************************
+*	void PlaceTileBuckets()
+*		Purpose:	Places the bucketed tiles a type at a time in tile type order. Within a bucket the
+*					tiles are in the order they were walked, so the random meshes are picked in the same
+*					order as walking the layout once per type. The buckets keep their memory for the next
+*					chunk.
+*
+*		Changes:
+*			m_tileBuckets - Emptied.
+*			m_tileChunks
+*				An instance is added for each tile in the buckets.
+**********************************************************************************************************/
+void AProceduralDungeon::PlaceTileBuckets()
+{
 	for (int i = 0; i < TileType::TileType_MAX; i++)
 	{
-		if (m_tileMeshes[i].Num() > 0)
+		for (int j = 0; j < m_tileBuckets[i].Num(); j++)
+			AddTileInstance(m_tileBuckets[i][j].tile, m_tileBuckets[i][j].x, m_tileBuckets[i][j].y);
+
+		m_tileBuckets[i].Reset();
+	}
+}
+/**********************************************************************************************************
+*	void RegisterTileMeshes()
+*		Purpose:	Registers the tile components once their instances have been added. The instances
+*					were written straight into each component's instance data while it was unregistered,
+*					so registering makes its render state and instance bodies once for every instance,
+*					instead of each AddInstance call dirtying them. The cluster tree of a hierarchical
+*					component is built from all of its instances at once before it is registered.
+*
+*		Changes:
+*			m_tileChunks
+*				Every component is registered.
+**********************************************************************************************************/
+void AProceduralDungeon::RegisterTileMeshes()
+{
+	for (auto & chunk : m_tileChunks)
+		RegisterTileMeshChunk(chunk.Value);
+}
+/**********************************************************************************************************
+*	void RegisterTileMeshChunk(TileMeshChunk & Chunk)
+*		Purpose:	Registers the components of one chunk that are not registered, building the cluster
+*					tree of each hierarchical one first. See RegisterTileMeshes.
+*
+*		Parameters:
+*			TileMeshChunk & Chunk
+*				The chunk to register.
+**********************************************************************************************************/
+void AProceduralDungeon::RegisterTileMeshChunk(TileMeshChunk & Chunk)
+{
+	for (int i = 0; i < TileType::TileType_MAX; i++)
+	{
+		for (int j = 0; j < Chunk.meshes[i].Num(); j++)
+		{
+			UInstancedStaticMeshComponent * mesh = Chunk.meshes[i][j];
+
+			if (mesh == nullptr || mesh->IsRegistered())
+				continue;
+
+			UHierarchicalInstancedStaticMeshComponent * hierarchical = Cast<UHierarchicalInstancedStaticMeshComponent>(mesh);
+
+			if (hierarchical != nullptr)
+				hierarchical->BuildTree();
+
+			mesh->RegisterComponent();
+		}
+	}
+}
+/**********************************************************************************************************
+*	void AddTileInstance(TileData Tile, int X, int Y)
+*		Purpose:	Picks a random mesh of the tile's type and places it at (X, Y) in the component its
+*					chunk has for the mesh. The component is not registered yet, so the instance is
+*					written straight into its instance data and nothing is dirtied, see
+*					RegisterTileMeshes. If instances are being deferred the tile is queued with the mesh
+*					picked instead, so the same meshes are picked whichever order the queue is placed in.
+*
+*		Parameters:
+*			TileData Tile
+*				The tile to place. Its type must have at least one mesh.
+*			int X, int Y
+*				The location of the tile in the layout.
+*
+*		Changes:
+*			m_tileChunks
+*				An instance is added to one of the meshes for the tile's type.
+*			m_pendingInstances - The tile is added instead if m_deferInstances is set.
+**********************************************************************************************************/
+void AProceduralDungeon::AddTileInstance(TileData Tile, int X, int Y)
+{
+	int type = Tile.GetTileType();
+
+	// Pick a random tile.
+	int randomIndex = m_randomStream.RandRange(0, m_TILE_TYPE_CONTAINER[type].Num() - 1);
+
+	if (m_TILE_TYPE_CONTAINER[type][randomIndex] == nullptr)
+		return;
+
+	TileMeshChunk & chunk = m_tileChunks.FindOrAdd(GetTileChunkKey(X, Y));
+	UInstancedStaticMeshComponent * mesh = GetTileMesh(chunk, type, randomIndex);
+
+	if (m_deferInstances)
+	{
+		PendingTileInstance pending;
+		pending.variant = randomIndex;
+		pending.tile = Tile;
+		pending.x = X;
+		pending.y = Y;
+
+		m_pendingInstances.Add(pending);
+		return;
+	}
+
+	AddInstanceData(mesh, GetTileTransform(Tile, X, Y));
+
+	chunk.instanceTiles[type][randomIndex].Add(FIntPoint(X, Y));
+}
+/**********************************************************************************************************
+*	void AddInstanceData(UInstancedStaticMeshComponent * Mesh, const FTransform & Transform)
+*		Purpose:	Adds an instance to a component that is not registered yet, without dirtying its
+*					render state or making a body for it. Registering the component later builds both for
+*					every instance at once. This mirrors the instance setup in
+*					UInstancedStaticMeshComponent::AddInstance and SetupNewInstanceData in UE 4.15, which
+*					mark a new instance as having no lightmap or shadowmap by setting its UV biases to -1.
+*					Check it against those when upgrading the engine.
+*
+*		Parameters:
+*			UInstancedStaticMeshComponent * Mesh
+*				The component to add to. Must not be registered.
+*			const FTransform & Transform
+*				The instance's transform, relative to the component.
+*
+*		Changes:
+*			Mesh - An instance is added to PerInstanceSMData.
+**********************************************************************************************************/
+void AProceduralDungeon::AddInstanceData(UInstancedStaticMeshComponent * Mesh, const FTransform & Transform)
+{
+	FInstancedStaticMeshInstanceData & instance = Mesh->PerInstanceSMData[Mesh->PerInstanceSMData.AddDefaulted()];
+	instance.Transform = Transform.ToMatrixWithScale();
+	instance.LightmapUVBias = FVector2D(-1, -1);
+	instance.ShadowmapUVBias = FVector2D(-1, -1);
+}
+/**********************************************************************************************************
+*	FTransform GetTileTransform(TileData Tile, int X, int Y)
+*		Purpose:	Builds the transform a tile is placed with, relative to the actor.
+*
+*		Parameters:
+*			TileData Tile
+*				The tile, which gives the rotation.
+*			int X, int Y
+*				The location of the tile in the layout.
+*
+*		Return:		The tile's transform.
+**********************************************************************************************************/
+FTransform AProceduralDungeon::GetTileTransform(TileData Tile, int X, int Y) const
+{
+	// Create translation.
+	FVector tileLocation = FVector(tileDimensions.X * X, tileDimensions.Y * Y, 0);
+
+	// Create Transform
+	return FTransform(Tile.GetRotation(), tileLocation, FVector(1, 1, 1));
+}
+/**********************************************************************************************************
+*	void OrderPendingInstances()
+*		Purpose:	Sorts the queued instances so the ones nearest the first player's camera are placed
+*					first. The layout is split into square blocks of m_INSTANCE_BLOCK_SIZE tiles and the
+*					blocks are ordered by how far their centers are from the camera, which is only looked
+*					up once, here. The instances are then bucketed into their blocks in two passes, one
+*					to count and one to fill, keeping the order they were queued in within a block. If
+*					there is no player the blocks nearest the actor go first.
+*
+*		Changes:
+*			m_pendingInstances - Reordered block by block, nearest first.
+*			m_nextPendingInstance - Set to 0.
+**********************************************************************************************************/
+void AProceduralDungeon::OrderPendingInstances()
+{
+	m_nextPendingInstance = 0;
+
+	FVector dimensions = m_dungeonLayout.GetDungeonDimensions();
+	int blocksX = FMath::Max(FMath::DivideAndRoundUp((int)dimensions.X, m_INSTANCE_BLOCK_SIZE), 1);
+	int blocksY = FMath::Max(FMath::DivideAndRoundUp((int)dimensions.Y, m_INSTANCE_BLOCK_SIZE), 1);
+
+	// The camera in tiles, from the actor's corner tile.
+	FVector viewerTile = FVector(0, 0, 0);
+	APlayerController * controller = GetWorld()->GetFirstPlayerController();
+
+	if (controller != nullptr && controller->PlayerCameraManager != nullptr)
+	{
+		viewerTile = GetActorTransform().InverseTransformPosition(controller->PlayerCameraManager->GetCameraLocation());
+		viewerTile.X /= tileDimensions.X != 0 ? tileDimensions.X : 1;
+		viewerTile.Y /= tileDimensions.Y != 0 ? tileDimensions.Y : 1;
+	}
+
+	TArray<int> blockOrder;
+	blockOrder.SetNumUninitialized(blocksX * blocksY);
+
+	for (int i = 0; i < blockOrder.Num(); i++)
+		blockOrder[i] = i;
+
+	blockOrder.StableSort([blocksX, viewerTile](int A, int B)
+	{
+		float half = m_INSTANCE_BLOCK_SIZE * 0.5f;
+		float distanceA = FVector2D::DistSquared(FVector2D((A % blocksX) * m_INSTANCE_BLOCK_SIZE + half, (A / blocksX) * m_INSTANCE_BLOCK_SIZE + half), FVector2D(viewerTile));
+		float distanceB = FVector2D::DistSquared(FVector2D((B % blocksX) * m_INSTANCE_BLOCK_SIZE + half, (B / blocksX) * m_INSTANCE_BLOCK_SIZE + half), FVector2D(viewerTile));
+
+		return distanceA < distanceB;
+	});
+
+	// Count the instances in each block, then turn the counts into where each block starts.
+	TArray<int> blockNext;
+	blockNext.Init(0, blocksX * blocksY);
+
+	for (int i = 0; i < m_pendingInstances.Num(); i++)
+	{
+		const PendingTileInstance & pending = m_pendingInstances[i];
+		blockNext[(pending.y / m_INSTANCE_BLOCK_SIZE) * blocksX + pending.x / m_INSTANCE_BLOCK_SIZE]++;
+	}
+
+	int start = 0;
+
+	for (int i = 0; i < blockOrder.Num(); i++)
+	{
+		int count = blockNext[blockOrder[i]];
+		blockNext[blockOrder[i]] = start;
+		start += count;
+	}
+
+	TArray<PendingTileInstance> ordered;
+	ordered.SetNumUninitialized(m_pendingInstances.Num());
+
+	for (int i = 0; i < m_pendingInstances.Num(); i++)
+	{
+		const PendingTileInstance & pending = m_pendingInstances[i];
+		ordered[blockNext[(pending.y / m_INSTANCE_BLOCK_SIZE) * blocksX + pending.x / m_INSTANCE_BLOCK_SIZE]++] = pending;
+	}
+
+	m_pendingInstances = MoveTemp(ordered);
+}
+/**********************************************************************************************************
+*	void ApplyPendingInstances(float BudgetMilliseconds)
+*		Purpose:	Places queued instances in order until BudgetMilliseconds have passed. The clock is
+*					only read every m_INSTANCE_BATCH instances, so a batch may run slightly over. Once the
+*					queue is empty it is freed and onDungeonMaterialized is broadcast.
+*
+*		Parameters:
+*			float BudgetMilliseconds
+*				How long to spend placing instances.
+*
+*		Changes:
+*			m_nextPendingInstance - Moved past the instances placed.
+*			m_pendingInstances - Emptied once every instance has been placed.
+**********************************************************************************************************/
+void AProceduralDungeon::ApplyPendingInstances(float BudgetMilliseconds)
+{
+	double endTime = FPlatformTime::Seconds() + BudgetMilliseconds / 1000.0;
+
+	while (m_nextPendingInstance < m_pendingInstances.Num())
+	{
+		int batchEnd = FMath::Min(m_nextPendingInstance + m_INSTANCE_BATCH, m_pendingInstances.Num());
+
+		for (; m_nextPendingInstance < batchEnd; m_nextPendingInstance++)
+		{
+			const PendingTileInstance & pending = m_pendingInstances[m_nextPendingInstance];
+			int type = pending.tile.GetTileType();
+			TileMeshChunk & chunk = m_tileChunks.FindChecked(GetTileChunkKey(pending.x, pending.y));
+
+			chunk.meshes[type][pending.variant]->AddInstance(GetTileTransform(pending.tile, pending.x, pending.y));
+			chunk.instanceTiles[type][pending.variant].Add(FIntPoint(pending.x, pending.y));
+		}
+
+		if (FPlatformTime::Seconds() >= endTime)
+			break;
+	}
+
+	if (m_nextPendingInstance < m_pendingInstances.Num())
+		return;
+
+	m_pendingInstances.Empty();
+	m_nextPendingInstance = 0;
+
+	onDungeonMaterialized.Broadcast();
+}
+/**********************************************************************************************************
+*	bool IsMaterializing()
+*		Purpose:	Checks if tile instances are still being placed over several frames.
+*
+*		Return:		True if there are queued instances left to place.
+**********************************************************************************************************/
+bool AProceduralDungeon::IsMaterializing() const
+{
+	return m_nextPendingInstance < m_pendingInstances.Num();
+}
+/**********************************************************************************************************
+*	void CountSubmittedInstances(int & Submitted, int & Total)
+*		Purpose:	Counts the tile instances and estimates how many of them are submitted to be drawn
+*					for the first player's view. Anything whose bounding sphere is inside the camera's
+*					cone and cull distance counts as submitted. A plain instanced mesh submits all of its
+*					instances if any of it is, while a hierarchical one only submits the leaf clusters
+*					that are. Instances not yet in the cluster tree are always submitted.
+*
+*		Parameters:
+*			int & Submitted
+*				Set to the number of instances submitted for the view.
+*			int & Total
+*				Set to the number of tile instances.
+**********************************************************************************************************/
+void AProceduralDungeon::CountSubmittedInstances(int & Submitted, int & Total) const
+{
+	Submitted = 0;
+	Total = 0;
+
+	APlayerController * player = GetWorld()->GetFirstPlayerController();
+
+	if (player == nullptr || player->PlayerCameraManager == nullptr)
+		return;
+
+	const FVector viewOrigin = player->PlayerCameraManager->GetCameraLocation();
+	const FVector viewDirection = player->PlayerCameraManager->GetCameraRotation().Vector();
+	const float halfFOV = FMath::DegreesToRadians(player->PlayerCameraManager->GetFOVAngle() * 0.5f);
+
+	auto isInView = [&](const FVector & Center, float Radius, float CullDistance)
+	{
+		const FVector toCenter = Center - viewOrigin;
+		const float distance = toCenter.Size();
+
+		if (distance <= Radius)
+			return true;
+
+		if (CullDistance > 0 && distance - Radius > CullDistance)
+			return false;
+
+		const float angle = FMath::Acos(FMath::Clamp(FVector::DotProduct(toCenter / distance, viewDirection), -1.0f, 1.0f));
+
+		return angle - FMath::Asin(Radius / distance) <= halfFOV;
+	};
+
+	for (const auto & chunk : m_tileChunks)
+	{
+		for (int i = 0; i < TileType::TileType_MAX; i++)
 		{
-			for (int y = 0; y < dungeonDimensions.Y; y++)
+			for (int j = 0; j < chunk.Value.meshes[i].Num(); j++)
 			{
-				for (int x = 0; x < dungeonDimensions.X; x++)
+				const UInstancedStaticMeshComponent * mesh = chunk.Value.meshes[i][j];
+
+				if (mesh == nullptr)
+					continue;
+
+				const int instances = mesh->PerInstanceSMData.Num();
+				const float cullDistance = mesh->InstanceEndCullDistance;
+
+				Total += instances;
+
+				if (!mesh->IsRegistered() || !isInView(mesh->Bounds.Origin, mesh->Bounds.SphereRadius, 0))
+					continue;
+
+				const UHierarchicalInstancedStaticMeshComponent * hierarchical = Cast<UHierarchicalInstancedStaticMeshComponent>(mesh);
+
+				if (hierarchical == nullptr || !hierarchical->ClusterTreePtr.IsValid() || hierarchical->ClusterTreePtr->Num() == 0)
 				{
-					// If the tile at that location is the type of this pass.
-					if (layout[y][x].tileType == i)
-					{
-						// Create translation.
-						FVector tileLocation = FVector(tileDimensions.X * x, tileDimensions.Y * y, 0);
+					Submitted += instances;
+					continue;
+				}
 
-						// Create Transform
-						FTransform tileTransform = FTransform(layout[y][x].tileRotation, tileLocation, FVector(1, 1, 1));
+				const TArray<FClusterNode> & clusters = *hierarchical->ClusterTreePtr;
+				const FTransform & toWorld = hierarchical->GetComponentToWorld();
+				const float scale = toWorld.GetMaximumAxisScale();
 
-						// Pick a random tile.
-						int randomIndex = m_randomStream.RandRange(0, m_tileMeshes[i].Num() - 1);
+				// The root cluster holds every instance that is in the tree.
+				Submitted += FMath::Max(instances - (clusters[0].LastInstance + 1), 0);
 
-						// Add a instance
-						if (m_tileMeshes[i][randomIndex]->GetStaticMesh() != nullptr)
-							m_tileMeshes[i][randomIndex]->AddInstance(tileTransform);
+				TArray<int> open;
+				open.Add(0);
+
+				while (open.Num() > 0)
+				{
+					const FClusterNode & cluster = clusters[open.Pop(false)];
+					const FVector center = toWorld.TransformPosition((cluster.BoundMin + cluster.BoundMax) * 0.5f);
+					const float radius = (cluster.BoundMax - cluster.BoundMin).Size() * 0.5f * scale;
+
+					if (!isInView(center, radius, cullDistance))
+						continue;
+
+					if (cluster.FirstChild < 0)
+					{
+						Submitted += cluster.LastInstance - cluster.FirstInstance + 1;
+						continue;
 					}
+
+					for (int child = cluster.FirstChild; child <= cluster.LastChild; child++)
+						open.Add(child);
 				}
 			}
-
 		}
 	}
+}
+/**********************************************************************************************************
+*	void GeneratePreview()
+*		Purpose:	Generates the layout up to its paths and shows a box for each room and path in place
+*					of the tiles. The layout is regenerated as a chunked layout, which stops before any
+*					tiles are made, so only the stages a change affects are run. When the tiles are built
+*					afterwards only the tile stage is left to run.
+*
+*					Each box is previewMesh stretched over the tiles of its room or path, centered the same
+*					way the tiles are placed.
+*
+*		Changes:
+*			m_dungeonLayout - Regenerated without tiles.
+*			m_previewShown - Set to true.
+*				The tile components are destroyed and a single preview component is added.
+**********************************************************************************************************/
+void AProceduralDungeon::GeneratePreview()
+{
+	CancelGeneration();
+
+	FDungeonGenerationOptions previewOptions = generationOptions;
+	previewOptions.bChunkedGeneration = true;
+
+	m_dungeonLayout.Regenerate(dungeonSize, smallestRoomSize, desiredRooms, pathWidth, erosionPasses, erosionChance, m_randomStream, previewOptions);
+
+	DestroyTileComponents();
+	m_previewShown = true;
+
+	if (previewMesh == nullptr)
+		return;
+
+	UInstancedStaticMeshComponent * preview = NewObject<UInstancedStaticMeshComponent>(this);
+
+	preview->bCastDynamicShadow = false;
+	preview->SetStaticMesh(previewMesh);
+	preview->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	preview->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	FBoxSphereBounds meshBounds = previewMesh->GetBounds();
+	FVector meshSize = meshBounds.BoxExtent * 2;
+
+	// Flat meshes are left unscaled on their flat axis.
+	meshSize.X = meshSize.X > KINDA_SMALL_NUMBER ? meshSize.X : 1;
+	meshSize.Y = meshSize.Y > KINDA_SMALL_NUMBER ? meshSize.Y : 1;
+
+	TArray<TileRect> floorRects = m_dungeonLayout.GetFloorRects();
+
+	for (int i = 0; i < floorRects.Num(); i++)
+	{
+		const TileRect & rect = floorRects[i];
+
+		FVector scale = FVector(tileDimensions.X * (rect.xEnd - rect.xStart) / meshSize.X, tileDimensions.Y * (rect.yEnd - rect.yStart) / meshSize.Y, 1);
+
+		// Tiles are placed at tileDimensions times their position, so the box is centered between the
+		// first and last tile placed.
+		FVector center = FVector(tileDimensions.X * (rect.xStart + rect.xEnd - 1) * 0.5f, tileDimensions.Y * (rect.yStart + rect.yEnd - 1) * 0.5f, 0);
+
+		preview->AddInstance(FTransform(FQuat::Identity, center - meshBounds.Origin * scale, scale));
+	}
+
+	// Registered after the boxes are added so its render state is only made once.
+	preview->RegisterComponent();
+}
+/**********************************************************************************************************
+*	void FinishPreview()
+*		Purpose:	Called once property changes have settled. Builds the tiles for the current
+*					properties in place of the preview, in the background if bGenerateAsync is set.
+*
+*		Changes:
+*			m_randomStream - Reset to randomSeed, as OnConstruction does.
+*				The preview is replaced with the tiles.
+**********************************************************************************************************/
+void AProceduralDungeon::FinishPreview()
+{
+	m_randomStream = FRandomStream(randomSeed);
+
+	if (bGenerateAsync)
+		GenerateTilesAsync();
+	else
+		GenerateTiles();
+}
+/**********************************************************************************************************
+*	void DestroyTileComponents()
+*		Purpose:	Destroys every component attached to the root, which are the tile components or the
+*					preview component. Any instances still queued for them are dropped.
+**********************************************************************************************************/
+void AProceduralDungeon::DestroyTileComponents()
+{
+	TArray<USceneComponent*> oldChildren = TArray<USceneComponent*>();
+
+	RootComponent->GetChildrenComponents(true, oldChildren);
+
+	for (int i = 0; i < oldChildren.Num(); i++)
+	{
+		oldChildren[i]->DestroyComponent();
+	}
+
+	// The chunks and queued instances belong to the components just destroyed.
+	m_tileChunks.Empty();
+	m_pendingInstances.Empty();
+	m_nextPendingInstance = 0;
 }
\ No newline at end of file
@@ -4,6 +4,42 @@
 #include "GameFramework/Actor.h"
 #include "ProceduralDungeon.generated.h"
 
+struct DungeonGenerationJob;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FDungeonGeneratedDelegate);
+
+/**********************************************************************************************************
+*	struct PendingTileInstance
+*
+*		Purpose:
+*			A tile waiting to be placed. Tiles are bucketed by type before their meshes are picked,
+*			with variant left at -1. When instances are spread over several frames the tile is queued
+*			with the index of its mesh already picked, so the meshes chosen do not depend on the order
+*			the tiles are placed in.
+**********************************************************************************************************/
+struct PendingTileInstance
+{
+	int variant;
+	TileData tile;
+	int x;
+	int y;
+};
+
+/**********************************************************************************************************
+*	struct TileMeshChunk
+*
+*		Purpose:
+*			The tile components of one square chunk of the dungeon. There is a slot for each mesh of each
+*			tile type, left null until a tile in the chunk uses that mesh, so each component's bounds
+*			only cover its chunk. instanceTiles is parallel to meshes and holds the tile each instance
+*			was placed for, in instance order, so a chunk can drop the instances of edited tiles.
+**********************************************************************************************************/
+struct TileMeshChunk
+{
+	TArray<UInstancedStaticMeshComponent *> meshes[TileType::TileType_MAX];
+	TArray<TArray<FIntPoint>> instanceTiles[TileType::TileType_MAX];
+};
+
 /**********************************************************************************************************
 *	Class: ProceduralDungeon
 *
@@ -18,17 +54,121 @@
 *			will be laid out in such a way that rooms and paths will be generated. Each room will be
 *			accessible from any other room.
 *
+*		Generating in the background:
+*			GenerateTilesAsync generates the layout on a worker thread so the game thread is not held
+*			up. The layout is moved into the job while it runs and moved back once it is done, then the
+*			tile components are built on the game thread, which is the only part that has to run there.
+*			Starting a new generation or a synchronous one cancels the generation in progress, and its
+*			result is thrown away. onDungeonGenerated is broadcast when a generation has been built.
+*			If bGenerateAsync is set, OnConstruction generates in the background as well.
+*
+*		Placing tiles over several frames:
+*			If instanceBudgetMilliseconds is above 0, the tile instances of a game world are queued
+*			instead of all being added at once, and Tick adds as many as fit in the budget each frame.
+*			The queue is split into square blocks of tiles, and the blocks nearest the first player's
+*			camera when the tiles were built are placed first. onDungeonMaterialized is broadcast once
+*			every tile has been placed, right away if they were all added at once.
+*
+*		Hierarchical instances:
+*			If bHierarchicalInstances is set, each tile mesh is a hierarchical instanced static mesh.
+*			Its instances are sorted into a tree of clusters, and the renderer culls and picks the LOD
+*			of each cluster instead of drawing every instance of the mesh whenever any of it is on
+*			screen. The tree is built once the instances are filled in, before the component is
+*			registered. Instances placed over several frames are added to the tree by the component.
+*			The ProceduralDungeon stat group ("stat ProceduralDungeon") counts the tile instances and
+*			roughly how many of them are submitted for the first player's view in either mode.
+*
+*		Chunks:
+*			The tiles are split into square chunks of tileChunkSize tiles, and each chunk has its own
+*			component for each mesh it uses. A component's bounds only cover its chunk, so chunks out of
+*			view are culled whole. SetFloor and SetFloorRect queue edits to the layout, and
+*			ApplyTileEdits solves the tiles around them and rebuilds only the chunks with a changed tile.
+*			Edits need a layout that is neither sparse nor chunked, and no generation in progress.
+*
+*		Preview:
+*			Changing a property in the editor, including every step of dragging a value, shows a
+*			preview instead of building the tiles. The preview is one box per room and path made from
+*			previewMesh, and skips making the tiles and their meshes. The tiles are built once no
+*			property has changed for previewSettleTime seconds. A change made while waiting starts
+*			the wait over, so only the last change is built.
+*
 *	Methods:
 *
 *		GenerateTiles()
 *			Generates a new set of tiles for the level using the tile arrays. The layout of the dungeon is
 *			dependent on the random seed. If no tiles are in the particular array, instead nothing will be
 *			created.
+*		BeginDestroy()
+*			Cancels any generation in progress so its worker stops early.
+*		GenerateTilesAsync(TFunction<void(bool)> OnFinished)
+*			GenerateTiles with the layout made on a worker thread. Returns the job's progress, which can
+*			also cancel it. OnFinished is called on the game thread with whether the tiles were built.
+*		SetFloor(int X, int Y, bool Floor)
+*			Queues an edit making one tile a floor or taking its floor away.
+*		SetFloorRect(int XStart, int YStart, int XEnd, int YEnd, bool Floor)
+*			Queues an edit making a rectangle of tiles floors or taking their floors away.
+*		ApplyTileEdits()
+*			Applies the queued edits and rebuilds the chunks they changed.
+*		CancelGeneration()
+*			Cancels the generation in progress, if any.
+*		IsGenerating()
+*			Returns if a generation is in progress.
+*		GetGenerationProgress()
+*			Returns how far the generation in progress has got, 1 if there is none.
+*		FinishGeneration(TSharedRef<DungeonGenerationJob, ESPMode::ThreadSafe> Job)
+*			Builds the tiles of a finished job on the game thread, unless it was cancelled.
+*		UpdateTileComponents(EDungeonStage Stage)
+*			Rebuilds the tile components from the layout if the stage or the tile meshes call for it.
+*		PostEditChangeProperty(FPropertyChangedEvent & PropertyChangedEvent)
+*			Editor only. Marks the construction run by a property change as one that should preview.
+*		GeneratePreview()
+*			Generates the layout without its tiles and places a box for each room and path.
+*		FinishPreview()
+*			Builds the tiles once a property change has settled.
+*		DestroyTileComponents()
+*			Destroys every tile or preview component attached to the root.
 *		InitializeTileArrays()
-*			Empties each tile array and sets its static mesh to the corresponding static mesh in types.
+*			Empties the tile chunks and gathers the meshes of each tile type.
+*		TileMeshesChanged()
+*			Returns if anything the tile components are built from, other than the layout, changed since
+*			the tiles were last built.
+*		GetTileChunkKey(int X, int Y)
+*			Returns the chunk a tile is in.
+*		GetTileMesh(TileMeshChunk & Chunk, int Type, int Variant)
+*			Returns a chunk's component for a mesh, making it the first time.
+*		RebuildTileChunks(const TArray<TileChange> & ChangedTiles)
+*			Replaces the instances of changed tiles, touching only the chunks they are in.
+*		GatherTileTypeMeshes(TArray<class UStaticMesh*> (&TileTypeMeshes)[TileType::TileType_MAX])
+*			Copies the tile arrays into a container indexed by tile type.
 *		CreateTileMeshes()
 *			Takes the data from the dungeon layout and creates tiles. Tiles are instanced static meshes and
 *			there is one for each tile type specified.
+*		CreateTileMeshesSparse()
+*			CreateTileMeshes for a sparse layout. Only walks the runs of built tiles.
+*		CreateTileMeshesChunked()
+*			CreateTileMeshes for a chunked layout. Makes and places one chunk at a time.
+*		BucketTile(TileData Tile, int X, int Y)
+*			Adds a tile to its type's bucket if the type has meshes.
+*		PlaceTileBuckets()
+*			Places the bucketed tiles a type at a time and empties the buckets.
+*		RegisterTileMeshes()
+*			Registers the tile components once their instances are filled in.
+*		RegisterTileMeshChunk(TileMeshChunk & Chunk)
+*			Registers the components of one chunk that are not registered.
+*		AddTileInstance(TileData Tile, int X, int Y)
+*			Places a random mesh for the tile at its location, or queues it if instances are deferred.
+*		GetTileTransform(TileData Tile, int X, int Y)
+*			Returns the transform a tile is placed with.
+*		AddInstanceData(UInstancedStaticMeshComponent * Mesh, const FTransform & Transform)
+*			Adds an instance to an unregistered component the way AddInstance sets it up.
+*		OrderPendingInstances()
+*			Sorts the queued instances into blocks, nearest the player first.
+*		ApplyPendingInstances(float BudgetMilliseconds)
+*			Places queued instances until the budget is used up.
+*		IsMaterializing()
+*			Returns if there are queued instances left to place.
+*		CountSubmittedInstances(int & Submitted, int & Total)
+*			Counts the tile instances and roughly how many are submitted for the first player's view.
 *		
 *	Data Members:
 *		int RandomSeed
@@ -43,15 +183,72 @@
 *			The width of paths connecting rooms.
 *		FVector tileDimensions
 *			How big each tile is in unreal units. Affects spacing of each tile.
+*		int erosionPasses
+*			The number of times the edges of rooms and paths are eroded.
+*		float erosionChance
+*			The chance of a wall touching a floor being eroded on each pass.
+*		FDungeonGenerationOptions generationOptions
+*			Picks the algorithms the dungeon layout is generated with.
+*		bool bGenerateAsync
+*			If OnConstruction generates the layout in the background.
+*		FDungeonGeneratedDelegate onDungeonGenerated
+*			Broadcast when a generation started by GenerateTilesAsync has been built.
+*		float instanceBudgetMilliseconds
+*			How long each frame may spend placing tile instances. At 0 or less every instance is added
+*			as soon as the tiles are built.
+*		FDungeonGeneratedDelegate onDungeonMaterialized
+*			Broadcast once every tile instance has been placed.
+*		bool bHierarchicalInstances
+*			If the tiles are built as hierarchical instanced static meshes, which are culled and have
+*			their LOD picked a cluster of instances at a time.
+*		int tileChunkSize
+*			The width and height in tiles of each chunk of tile components. At 0 or less the whole
+*			dungeon is one chunk.
+*		bool bPreviewWhileEditing
+*			If property changes in the editor show a preview until they settle.
+*		float previewSettleTime
+*			How many seconds without a property change before the tiles are built. At 0 or less the
+*			tiles are built on every change.
+*		UStaticMesh * previewMesh
+*			The mesh stretched over each room and path in the preview. Defaults to the engine cube.
 *		TArray<class UStaticMesh *> EmptyTiles
 *			An array containing a list of all the types of tiles that could be used when an empty tile is 
 *			required. There is one for each type of tile.
-*		TArray<UInstancedStaticMeshComponent *> tileMeshes[]
-*			Contains all actual static meshes used to build the level.
+*		TMap<FIntPoint, TileMeshChunk> m_tileChunks
+*			Contains all actual static meshes used to build the level, by the chunk they are in. Chunks
+*			with no tiles are left out.
+*		TArray<PendingTileInstance> m_tileBuckets[]
+*			The tiles of each type waiting for a mesh to be picked, in the order they were walked.
 *		FRandomStream m_randomStream
 *			The random stream used to generate randomization for the dungeon.
 *		DungeonLayout m_dungeonLayout
-*			Contains the layout information for the dungeon.
+*			Contains the layout information for the dungeon. Kept between builds so only the stages
+*			affected by a change are run again. Holds the last completed layout while a job
+*			generates a copy of it.
+*		FVector m_builtTileDimensions
+*			The tile dimensions the current tiles were built with.
+*		bool m_builtHierarchical
+*			If the current tiles were built as hierarchical instanced static meshes.
+*		int m_builtTileChunkSize
+*			The chunk size the current tiles were built with.
+*		TSharedPtr<DungeonGenerationJob, ESPMode::ThreadSafe> m_generationJob
+*			The generation in progress, null if there is none.
+*		FTimerHandle m_previewTimer
+*			The wait for property changes to settle before building the tiles.
+*		bool m_propertyChangePending
+*			True while the construction run by a property change in the editor is in progress.
+*		bool m_previewShown
+*			True if the preview is showing instead of the tiles.
+*		TArray<PendingTileInstance> m_pendingInstances
+*			The tile instances waiting to be placed, in the order they will be placed.
+*		int m_nextPendingInstance
+*			The first instance in m_pendingInstances that has not been placed.
+*		bool m_deferInstances
+*			True while the tiles are being built if AddTileInstance should queue instances.
+*		static const int m_INSTANCE_BLOCK_SIZE
+*			The width and height in tiles of the blocks the queued instances are ordered by.
+*		static const int m_INSTANCE_BATCH
+*			The number of instances placed between checks of the frame budget.
 **********************************************************************************************************/
 UCLASS()
 class HALVA_API AProceduralDungeon : public AActor
@@ -70,7 +267,29 @@ public:
 
 	virtual void OnConstruction(const FTransform & Transform) override;
 
+	virtual void BeginDestroy() override;
+
 	void GenerateTiles();
+	TSharedRef<DungeonGenerationProgress, ESPMode::ThreadSafe> GenerateTilesAsync(TFunction<void(bool)> OnFinished = TFunction<void(bool)>());
+
+	UFUNCTION(BlueprintCallable, Category = "DungeonLayout")
+		bool SetFloor(int X, int Y, bool Floor);
+	UFUNCTION(BlueprintCallable, Category = "DungeonLayout")
+		bool SetFloorRect(int XStart, int YStart, int XEnd, int YEnd, bool Floor);
+	UFUNCTION(BlueprintCallable, Category = "DungeonLayout")
+		void ApplyTileEdits();
+	UFUNCTION(BlueprintCallable, Category = "DungeonLayout")
+		void CancelGeneration();
+	UFUNCTION(BlueprintPure, Category = "DungeonLayout")
+		bool IsGenerating() const;
+	UFUNCTION(BlueprintPure, Category = "DungeonLayout")
+		float GetGenerationProgress() const;
+	UFUNCTION(BlueprintPure, Category = "DungeonLayout")
+		bool IsMaterializing() const;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent & PropertyChangedEvent) override;
+#endif
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RandomSeed")
 		int randomSeed;
@@ -88,6 +307,26 @@ public:
 		int erosionPasses;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DungeonLayout")
 		float erosionChance;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DungeonLayout")
+		FDungeonGenerationOptions generationOptions;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DungeonLayout")
+		bool bGenerateAsync;
+	UPROPERTY(BlueprintAssignable, Category = "DungeonLayout")
+		FDungeonGeneratedDelegate onDungeonGenerated;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DungeonLayout")
+		float instanceBudgetMilliseconds;
+	UPROPERTY(BlueprintAssignable, Category = "DungeonLayout")
+		FDungeonGeneratedDelegate onDungeonMaterialized;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DungeonLayout")
+		bool bHierarchicalInstances;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DungeonLayout")
+		int tileChunkSize;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Preview")
+		bool bPreviewWhileEditing;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Preview")
+		float previewSettleTime;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Preview")
+		class UStaticMesh * previewMesh;
 
 	// Parallel arrays are used for user entering data's convenience.
 
@@ -141,14 +380,51 @@ public:
 
 protected:
 
-	TArray<UInstancedStaticMeshComponent *> m_tileMeshes[TileType::TileType_MAX];
+	TMap<FIntPoint, TileMeshChunk> m_tileChunks;
 	
 	TArray<class UStaticMesh*> m_TILE_TYPE_CONTAINER[TileType::TileType_MAX];
 
+	TArray<PendingTileInstance> m_tileBuckets[TileType::TileType_MAX];
+
 	void InitializeTileArrays();
+	bool TileMeshesChanged();
+	FIntPoint GetTileChunkKey(int X, int Y) const;
+	UInstancedStaticMeshComponent * GetTileMesh(TileMeshChunk & Chunk, int Type, int Variant);
+	void RebuildTileChunks(const TArray<TileChange> & ChangedTiles);
+	void GatherTileTypeMeshes(TArray<class UStaticMesh*> (&TileTypeMeshes)[TileType::TileType_MAX]);
 	void CreateTileMeshes();
+	void CreateTileMeshesSparse();
+	void CreateTileMeshesChunked();
+	void BucketTile(TileData Tile, int X, int Y);
+	void PlaceTileBuckets();
+	void RegisterTileMeshes();
+	void RegisterTileMeshChunk(TileMeshChunk & Chunk);
+	void AddTileInstance(TileData Tile, int X, int Y);
+	FTransform GetTileTransform(TileData Tile, int X, int Y) const;
+	static void AddInstanceData(UInstancedStaticMeshComponent * Mesh, const FTransform & Transform);
+	void OrderPendingInstances();
+	void ApplyPendingInstances(float BudgetMilliseconds);
+	void CountSubmittedInstances(int & Submitted, int & Total) const;
+	void FinishGeneration(TSharedRef<DungeonGenerationJob, ESPMode::ThreadSafe> Job);
+	void UpdateTileComponents(EDungeonStage Stage);
+	void GeneratePreview();
+	void FinishPreview();
+	void DestroyTileComponents();
 
 	FRandomStream m_randomStream;
 	DungeonLayout m_dungeonLayout;
+	FVector m_builtTileDimensions;
+	bool m_builtHierarchical;
+	int m_builtTileChunkSize;
+	TSharedPtr<DungeonGenerationJob, ESPMode::ThreadSafe> m_generationJob;
+	FTimerHandle m_previewTimer;
+	bool m_propertyChangePending;
+	bool m_previewShown;
+	TArray<PendingTileInstance> m_pendingInstances;
+	int m_nextPendingInstance;
+	bool m_deferInstances;
+
+	static const int m_INSTANCE_BLOCK_SIZE = 16;
+	static const int m_INSTANCE_BATCH = 64;
 
 };
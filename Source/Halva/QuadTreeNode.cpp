@@ -2,6 +2,8 @@
 
 #include "Halva.h"
 #include "QuadTreeNode.h"
+#include "QuadTreeNodeArena.h"
+#include "Async/ParallelFor.h"
 /**********************************************************************************************************
 *	QuadTreeNode()
 *		Purpose:	Default constructor. Results in a blank object.
@@ -12,12 +14,15 @@ QuadTreeNode::QuadTreeNode()
 	m_stream = FRandomStream(0);
 	m_minimumQuadSize = FVector(0, 0, 0);
 	m_room = Quad();
+	m_splitStreams = false;
+	m_arena = nullptr;
 
 	for (int i = 0; i < 4; i++)
 		m_children[i] = nullptr;
 }
 /**********************************************************************************************************
-*	QuadTreeNode(int Depth, Quad Bounds, FVector MinimumQuadSize, FRandomStream Stream)
+*	QuadTreeNode(int Depth, Quad Bounds, FVector MinimumQuadSize, FRandomStream Stream, bool SplitStreams,
+*				 QuadTreeNodeArena * Arena)
 *		Purpose:	Constructor. Recursively creates children node until depth reaches 0. The children will
 *					be their parent sliced up into 4ths. No slice shall be smaller than minimum room size
 *					and the size of each slice is randomized. Stream is used for randomization.
@@ -30,13 +35,20 @@ QuadTreeNode::QuadTreeNode()
 *				The smallest possible leaf node Quad that can be built.
 *			FRandomStream Stream
 *				A random stream object to generate randomness.
+*			bool SplitStreams
+*				If true each child gets its own stream split off of Stream's seed, otherwise every child
+*				gets a copy of Stream.
+*			QuadTreeNodeArena * Arena
+*				The arena to allocate children from. If nullptr children are allocated on the heap.
 **********************************************************************************************************/
-QuadTreeNode::QuadTreeNode(int Depth, Quad Bounds, FVector MinimumQuadSize, FRandomStream Stream)
+QuadTreeNode::QuadTreeNode(int Depth, Quad Bounds, FVector MinimumQuadSize, FRandomStream Stream, bool SplitStreams, QuadTreeNodeArena * Arena)
 {
 	m_quad = Bounds;
 	m_minimumQuadSize = MinimumQuadSize;
 	m_stream = Stream;
 	m_room = Quad();
+	m_splitStreams = SplitStreams;
+	m_arena = Arena;
 
 	bool childrenMade = false;
 	
@@ -59,75 +71,15 @@ QuadTreeNode::QuadTreeNode(int Depth, Quad Bounds, FVector MinimumQuadSize, FRan
 	}
 }
 /**********************************************************************************************************
-*	QuadTreeNode(const QuadTreeNode & Source)
-*		Purpose:	Copy constructor. Deep copy.
-*
-*		Parameters:
-*			const QuadTreeNode & Source
-*				The QuadTreeNode to copy from.
-**********************************************************************************************************/
-QuadTreeNode::QuadTreeNode(const QuadTreeNode & Source)
-{
-	m_quad = Source.m_quad;
-	m_stream = Source.m_stream;
-	m_minimumQuadSize = Source.m_minimumQuadSize;
-	m_room = Source.m_room;
-
-	for (int i = 0; i < 4; i++)
-	{
-		m_children[i] = nullptr;
-
-		if (Source.m_children[i] != nullptr)
-			m_children[i] = new QuadTreeNode(*(Source.m_children[i]));
-	}
-}
-/**********************************************************************************************************
-*	QuadTreeNode & operator=(const QuadTreeNode & Source)
-*		Purpose:	operator=. Assigns RHS to LHS. Deep copy.
-*
-*		Parameters:
-*			const QuadTreeNode & Source
-*				The object to copy data from.
-*
-*		Return:		Returns this by reference.
-**********************************************************************************************************/
-QuadTreeNode & QuadTreeNode::operator=(const QuadTreeNode & Source)
-{
-	if (&Source != this)
-	{
-		m_quad = Source.m_quad;
-		m_stream = Source.m_stream;
-		m_minimumQuadSize = Source.m_minimumQuadSize;
-		m_room = Source.m_room;
-
-		for (int i = 0; i < 4; i++)
-		{
-			if (m_children[i] != nullptr)
-				delete m_children[i];
-
-			m_children[i] = nullptr;
-
-			if (Source.m_children[i] != nullptr)
-				m_children[i] = new QuadTreeNode(*Source.m_children[i]);
-		}
-	}
-	return *this;
-}
-/**********************************************************************************************************
 *	~QuadTreeNode()
-*		Purpose:	Destructor. Frees all children belonging to this node.
+*		Purpose:	Destructor. Frees all children belonging to this node. Children allocated from an arena
+*					are freed with the arena instead.
 *
 *		Changes:	m_children will be deleted.
 **********************************************************************************************************/
 QuadTreeNode::~QuadTreeNode()
 {
-	for (int i = 0; i < 4; i++)
-	{
-		if (m_children[i] != nullptr)
-			delete(m_children[i]);
-
-		m_children[i] = nullptr;
-	}
+	ReleaseChildren();
 }
 /**********************************************************************************************************
 *	bool CreateChildren(int Depth)
@@ -137,6 +89,10 @@ QuadTreeNode::~QuadTreeNode()
 *					does not have enough space to support the number divisions requested, false will be
 *					returned and no divisions will be made.
 *
+*					If m_splitStreams is set, child i gets a stream split off of the seed of m_stream with
+*					index i. The children then share no state, so when they will have children of their
+*					own they are built in parallel.
+*
 *		Parameters: 
 *			int Depth
 *				The number of times to cut the children. If 1 4 children will be created, if 2,
@@ -161,19 +117,70 @@ bool QuadTreeNode::CreateChildren(int Depth)
 	{
 		QuadSlices childQuads = Slice(Depth);
 
-		for (int i = 0; i < 4; i++)
-			if (m_children[i] != nullptr)
-				delete m_children[i];
+		ReleaseChildren();
 
-		m_children[0] = new QuadTreeNode(Depth - 1, childQuads.southWest, m_minimumQuadSize, m_stream);
-		m_children[1] = new QuadTreeNode(Depth - 1, childQuads.northWest, m_minimumQuadSize, m_stream);
-		m_children[2] = new QuadTreeNode(Depth - 1, childQuads.northEast, m_minimumQuadSize, m_stream);
-		m_children[3] = new QuadTreeNode(Depth - 1, childQuads.southEast, m_minimumQuadSize, m_stream);
+		if (m_splitStreams)
+		{
+			Quad childBounds[4] = { childQuads.southWest, childQuads.northWest, childQuads.northEast, childQuads.southEast };
+			int32 seed = m_stream.GetInitialSeed();
+
+			// Children at the bottom of the tree are too small to be worth a task.
+			ParallelFor(4, [&](int32 Child)
+			{
+				m_children[Child] = CreateChild(Depth - 1, childBounds[Child], DungeonRandom::DeriveStream(seed, Child));
+			}, Depth <= 1);
+		}
+		else
+		{
+			m_children[0] = CreateChild(Depth - 1, childQuads.southWest, m_stream);
+			m_children[1] = CreateChild(Depth - 1, childQuads.northWest, m_stream);
+			m_children[2] = CreateChild(Depth - 1, childQuads.northEast, m_stream);
+			m_children[3] = CreateChild(Depth - 1, childQuads.southEast, m_stream);
+		}
 	}
 
 	return willFit;
 }
 /**********************************************************************************************************
+*	QuadTreeNode * CreateChild(int Depth, Quad Bounds, FRandomStream Stream)
+*		Purpose:	Builds a child node, and its subtree, in m_arena. Falls back to the heap when this node
+*					has no arena. The child shares this node's settings and arena.
+*
+*		Parameters:
+*			int Depth
+*				The depth to build the child's subtree to.
+*			Quad Bounds
+*				The child's quad.
+*			FRandomStream Stream
+*				The child's random stream.
+*
+*		Return:		The new child.
+**********************************************************************************************************/
+QuadTreeNode * QuadTreeNode::CreateChild(int Depth, Quad Bounds, FRandomStream Stream)
+{
+	if (m_arena != nullptr)
+		return new (m_arena->Allocate()) QuadTreeNode(Depth, Bounds, m_minimumQuadSize, Stream, m_splitStreams, m_arena);
+
+	return new QuadTreeNode(Depth, Bounds, m_minimumQuadSize, Stream, m_splitStreams);
+}
+/**********************************************************************************************************
+*	void ReleaseChildren()
+*		Purpose:	Lets go of this node's children. Children on the heap are deleted along with their
+*					subtrees, children in an arena are left for the arena to free.
+*
+*		Changes:	m_children will all be nullptr.
+**********************************************************************************************************/
+void QuadTreeNode::ReleaseChildren()
+{
+	for (int i = 0; i < 4; i++)
+	{
+		if (m_children[i] != nullptr && m_arena == nullptr)
+			delete m_children[i];
+
+		m_children[i] = nullptr;
+	}
+}
+/**********************************************************************************************************
 *	QuadSlices Slice()
 *		Purpose:	Slices this quad into 4 smaller quads. these quads are not of even size but the sum
 *					of their area will add up to the area of this quad. The 4 quads will be returned as
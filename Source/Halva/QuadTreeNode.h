@@ -2,6 +2,9 @@
 
 #pragma once
 #include "Quad.h"
+#include "DungeonRandom.h"
+
+class QuadTreeNodeArena;
 
 struct QuadSlices
 {
@@ -21,17 +24,19 @@ struct QuadSlices
 *
 *	Manager Functions:
 *
-*		QuadTreeNode(FVector Bounds, FVector offset, FVector MinimumQuadSize, FRandomStream Stream);
+*		QuadTreeNode(int Depth, Quad Bounds, FVector MinimumQuadSize, FRandomStream Stream, bool SplitStreams,
+*					 QuadTreeNodeArena * Arena);
 *			Creates a new node in the quad tree and recursively creates children beneath it. If depth is
 *			set to 1, no children will be created. If set to 2, 1 set of children will be created. 2 will
-*			cause the children to have children and so forth.
+*			cause the children to have children and so forth. If SplitStreams is set each child gets a
+*			stream split off of this node's seed and the children are built in parallel. If Arena is set
+*			the children are allocated from it instead of the heap.
 *			
-*		QuadTreeNode(const QuadTreeNode & source);
-*			Copy constructor. takes in source and creates a copy of it.
 *		~QuadTreeNode();
-*			Destructor. Frees all children.
-*		QuadTreeNode & operator=(const QuadTreeNode & source);
-*			Assignment operator.
+*			Destructor. Frees all children unless they belong to an arena.
+*
+*		A tree is only built to be flattened into a LinearQuadTree and is never copied or moved, so
+*		copying and moving are deleted.
 *
 *	Mutators
 *		Children
@@ -58,6 +63,10 @@ struct QuadSlices
 *			PlannedDivisions rooms of minimum room size. This means that if planned divisions is 2 each 
 *			child will have enough space for 4 rooms (2 across and 2 down). A planned divisions value of 3
 *			will support 8 rooms.
+*		QuadTreeNode * CreateChild(int Depth, Quad Bounds, FRandomStream Stream);
+*			Allocates and constructs a child from m_arena, or the heap if there is no arena.
+*		void ReleaseChildren();
+*			Lets go of the children, deleting them if they are on the heap.
 *		
 *			
 *	Data Members:
@@ -72,17 +81,23 @@ struct QuadSlices
 *			The smallest leaf node Quad that can be generated.	
 *		FRandomStream m_stream
 *			The random stream used to generate randomness.
+*		bool m_splitStreams
+*			If children get streams split off of m_stream's seed instead of copies of m_stream.
+*		QuadTreeNodeArena * m_arena
+*			The arena the children were allocated from. If nullptr the children are on the heap and are
+*			owned by this node.
 **********************************************************************************************************/
 class HALVA_API QuadTreeNode
 {
 public:
 
 	QuadTreeNode();
-	QuadTreeNode(int Depth, Quad Bounds, FVector MinimumQuadSize, FRandomStream Stream);
-	QuadTreeNode(const QuadTreeNode & source);
-	QuadTreeNode & operator=(const QuadTreeNode & source);
+	QuadTreeNode(int Depth, Quad Bounds, FVector MinimumQuadSize, FRandomStream Stream, bool SplitStreams = false, QuadTreeNodeArena * Arena = nullptr);
 	~QuadTreeNode();
 
+	QuadTreeNode(const QuadTreeNode & Source) = delete;
+	QuadTreeNode & operator=(const QuadTreeNode & Source) = delete;
+
 	QuadTreeNode ** GetChildren();
 	Quad GetQuad() const;
 	Quad GetRoom() const;
@@ -96,11 +111,15 @@ private:
 
 	bool CreateChildren(int Depth);
 	QuadSlices Slice(int PlannedDivisions);
+	QuadTreeNode * CreateChild(int Depth, Quad Bounds, FRandomStream Stream);
+	void ReleaseChildren();
 
 	QuadTreeNode * m_children[4];
 	Quad m_quad;
 	Quad m_room;
 	FVector m_minimumQuadSize;
 	FRandomStream m_stream;
+	bool m_splitStreams;
+	QuadTreeNodeArena * m_arena;
 };
 
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "QuadTreeNodeArena.h"
+
+/**********************************************************************************************************
+*	QuadTreeNodeArena()
+*		Purpose:	Default constructor. Results in an empty arena.
+**********************************************************************************************************/
+QuadTreeNodeArena::QuadTreeNodeArena()
+{
+	m_chunks = TArray<QuadTreeNode *>();
+	m_numNodes = 0;
+}
+/**********************************************************************************************************
+*	~QuadTreeNodeArena()
+*		Purpose:	Destructor. Frees every node in the arena.
+**********************************************************************************************************/
+QuadTreeNodeArena::~QuadTreeNodeArena()
+{
+	Reset();
+}
+/**********************************************************************************************************
+*	void * Allocate()
+*		Purpose:	Hands out memory for one node, starting a new chunk when the last one is full. The
+*					node must be constructed in the memory with placement new before the arena is reset.
+*
+*		Changes:
+*			m_chunks - A chunk is added every m_NODES_PER_CHUNK nodes.
+*			m_numNodes - Increased by 1.
+*
+*		Return:		Uninitialized memory the size of a QuadTreeNode.
+**********************************************************************************************************/
+void * QuadTreeNodeArena::Allocate()
+{
+	FScopeLock lock(&m_lock);
+
+	int slot = m_numNodes % m_NODES_PER_CHUNK;
+
+	if (slot == 0)
+		m_chunks.Add((QuadTreeNode *)FMemory::Malloc(sizeof(QuadTreeNode) * m_NODES_PER_CHUNK, alignof(QuadTreeNode)));
+
+	m_numNodes++;
+
+	return m_chunks.Last() + slot;
+}
+/**********************************************************************************************************
+*	void Reset()
+*		Purpose:	Destroys every node and frees all chunks in one go. Nodes in the arena do not own
+*					their children so destroying them does not touch any other node.
+*
+*		Changes:
+*			m_chunks - Emptied.
+*			m_numNodes - Set to 0.
+**********************************************************************************************************/
+void QuadTreeNodeArena::Reset()
+{
+	FScopeLock lock(&m_lock);
+
+	for (int i = 0; i < m_numNodes; i++)
+		m_chunks[i / m_NODES_PER_CHUNK][i % m_NODES_PER_CHUNK].~QuadTreeNode();
+
+	for (int i = 0; i < m_chunks.Num(); i++)
+		FMemory::Free(m_chunks[i]);
+
+	m_chunks.Empty();
+	m_numNodes = 0;
+}
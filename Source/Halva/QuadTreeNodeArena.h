@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "QuadTreeNode.h"
+/**********************************************************************************************************
+*	Class: QuadTreeNodeArena
+*
+*	Overview:
+*		Scratch storage for the nodes of a quad tree while it is built. DungeonLayout's constructor
+*		builds the pointer tree in an arena, flattens it into a LinearQuadTree and then destroys the
+*		arena, so no tree outlives its construction. Nodes are handed out of large chunks instead of
+*		being allocated one at a time, and the whole tree is freed at once when the arena is destroyed
+*		or reset. Chunks are never moved once allocated so pointers to nodes stay valid for the life of
+*		the arena. Allocate is safe to call from several threads at once, so the tree can be built in
+*		parallel.
+*
+*	Manager Functions:
+*
+*		QuadTreeNodeArena();
+*			Default constructor. No memory is allocated until the first node is.
+*		~QuadTreeNodeArena();
+*			Destructor. Destroys every node and frees every chunk.
+*
+*	Methods:
+*
+*		void * Allocate()
+*			Returns memory for one node. The caller must construct a QuadTreeNode in it with placement new.
+*		void Reset()
+*			Destroys every node and frees every chunk.
+*
+*	Data Members:
+*
+*		TArray<QuadTreeNode *> m_chunks
+*			Each chunk holds m_NODES_PER_CHUNK nodes.
+*		int m_numNodes
+*			The number of nodes handed out.
+*		FCriticalSection m_lock
+*			Guards m_chunks and m_numNodes while the tree is built in parallel.
+*		static const int m_NODES_PER_CHUNK
+*			The number of nodes allocated at a time.
+**********************************************************************************************************/
+class HALVA_API QuadTreeNodeArena
+{
+public:
+
+	QuadTreeNodeArena();
+	~QuadTreeNodeArena();
+
+	QuadTreeNodeArena(const QuadTreeNodeArena & Source) = delete;
+	QuadTreeNodeArena & operator=(const QuadTreeNodeArena & Source) = delete;
+
+	void * Allocate();
+	void Reset();
+
+private:
+
+	TArray<QuadTreeNode *> m_chunks;
+	int m_numNodes;
+	FCriticalSection m_lock;
+
+	static const int m_NODES_PER_CHUNK = 256;
+};
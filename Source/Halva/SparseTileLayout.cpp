@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "SparseTileLayout.h"
+
+/**********************************************************************************************************
+*	SparseTileLayout()
+*		Purpose:	Default constructor. Results in a 0x0 layout.
+**********************************************************************************************************/
+SparseTileLayout::SparseTileLayout()
+{
+	m_width = 0;
+	m_height = 0;
+}
+/**********************************************************************************************************
+*	SparseTileLayout(TileLayoutView Layout)
+*		Purpose:	Constructor. Creates a sparse copy of Layout.
+*
+*		Parameters:
+*			TileLayoutView Layout
+*				The tiles to copy.
+**********************************************************************************************************/
+SparseTileLayout::SparseTileLayout(TileLayoutView Layout)
+{
+	Build(Layout);
+}
+/**********************************************************************************************************
+*	int GetWidth()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int SparseTileLayout::GetWidth() const
+{
+	return m_width;
+}
+/**********************************************************************************************************
+*	int GetHeight()
+*		Purpose:	Getter.
+**********************************************************************************************************/
+int SparseTileLayout::GetHeight() const
+{
+	return m_height;
+}
+/**********************************************************************************************************
+*	const SparseTileRun & GetRun(int Index)
+*		Purpose:	Getter.
+**********************************************************************************************************/
+const SparseTileRun & SparseTileLayout::GetRun(int Index) const
+{
+	return m_runs[Index];
+}
+/**********************************************************************************************************
+*	const TileData * GetRunTiles(int Index)
+*		Purpose:	Getter. Returns the first tile of run Index, the rest of the run follows it.
+**********************************************************************************************************/
+const TileData * SparseTileLayout::GetRunTiles(int Index) const
+{
+	return m_tiles.GetData() + m_runs[Index].firstTile;
+}
+/**********************************************************************************************************
+*	void Build(TileLayoutView Layout)
+*		Purpose:	Replaces the contents with a sparse copy of Layout. Each row is scanned for runs of
+*					tiles that are not empty. Empty tiles are a zero byte, so 8 tiles are checked at a
+*					time while skipping over empty space.
+*
+*		Parameters:
+*			TileLayoutView Layout
+*				The tiles to copy.
+*
+*		Changes:
+*			m_runs, m_tiles, m_rowFirstRun - Hold the runs of Layout.
+*			m_width, m_height - Set to the size of Layout.
+**********************************************************************************************************/
+void SparseTileLayout::Build(TileLayoutView Layout)
+{
+	static_assert(emptyTile == 0, "Empty tiles are expected to pack to a zero byte.");
+
+	Empty();
+
+	m_width = Layout.width;
+	m_height = Layout.height;
+	m_rowFirstRun.SetNumUninitialized(m_height + 1);
+
+	for (int y = 0; y < m_height; y++)
+	{
+		const TileData * row = Layout.GetRow(y);
+		int x = 0;
+
+		m_rowFirstRun[y] = m_runs.Num();
+
+		while (x < m_width)
+		{
+			// Skip the empties, 8 at a time while a whole word of them is left.
+			while (x + 8 <= m_width)
+			{
+				uint64 word;
+				FMemory::Memcpy(&word, row + x, sizeof(word));
+
+				if (word != 0)
+					break;
+
+				x += 8;
+			}
+
+			while (x < m_width && row[x].packedTile == 0)
+				x++;
+
+			if (x == m_width)
+				break;
+
+			int xStart = x;
+
+			while (x < m_width && row[x].packedTile != 0)
+				x++;
+
+			SparseTileRun run;
+			run.y = y;
+			run.xStart = xStart;
+			run.count = x - xStart;
+			run.firstTile = m_tiles.Num();
+
+			m_runs.Add(run);
+			m_tiles.Append(row + xStart, run.count);
+		}
+	}
+
+	m_rowFirstRun[m_height] = m_runs.Num();
+}
+/**********************************************************************************************************
+*	void Empty()
+*		Purpose:	Removes every tile and makes the layout 0x0.
+*
+*		Changes:
+*			m_runs, m_tiles, m_rowFirstRun - Emptied.
+*			m_width, m_height - Set to 0.
+**********************************************************************************************************/
+void SparseTileLayout::Empty()
+{
+	m_runs.Empty();
+	m_tiles.Empty();
+	m_rowFirstRun.Empty();
+	m_width = 0;
+	m_height = 0;
+}
+/**********************************************************************************************************
+*	void GetRowRuns(int Y, int & FirstRun, int & EndRun)
+*		Purpose:	Finds the runs in a row.
+*
+*		Parameters:
+*			int Y
+*				The row. Must be inside the layout.
+*			int & FirstRun, int & EndRun
+*				Set to the index of the first run in the row and one past the last. Equal if the row is
+*				all empty.
+**********************************************************************************************************/
+void SparseTileLayout::GetRowRuns(int Y, int & FirstRun, int & EndRun) const
+{
+	check(Y >= 0 && Y < m_height);
+
+	FirstRun = m_rowFirstRun[Y];
+	EndRun = m_rowFirstRun[Y + 1];
+}
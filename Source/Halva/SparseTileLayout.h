@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "TileStructure.h"
+/**********************************************************************************************************
+*	struct SparseTileRun
+*
+*		Purpose:
+*			A run of tiles in one row of a SparseTileLayout that are not empty.
+*
+*		Members:
+*			int y
+*				The row the run is in.
+*			int xStart
+*				The X of the first tile in the run.
+*			int count
+*				The number of tiles in the run.
+*			int firstTile
+*				The index in the layout's tile list of the first tile of the run. The run's tiles follow
+*				it in order.
+**********************************************************************************************************/
+struct SparseTileRun
+{
+	int y;
+	int xStart;
+	int count;
+	int firstTile;
+
+	// One past the X of the last tile in the run.
+	int GetXEnd() const
+	{
+		return xStart + count;
+	}
+};
+/**********************************************************************************************************
+*	Class: SparseTileLayout
+*
+*	Overview:
+*		A compacted copy of a finished tile layout that only stores the tiles that are not empty. Each
+*		row is run length encoded as the runs of non empty tiles in it, every other tile is empty. The
+*		runs are kept in row order and their tiles are packed back to back in one list, so the memory
+*		kept and the time to walk every built tile follow the number of rooms, paths and walls rather
+*		than the size of the map. The only per map cost is one index per row. It is built from a dense
+*		layout, so building one still costs a pass over the whole map.
+*
+*	Manager Functions:
+*
+*		SparseTileLayout();
+*			Default constructor. Results in a 0x0 layout.
+*		SparseTileLayout(TileLayoutView Layout);
+*			Creates a sparse copy of Layout.
+*
+*	Mutators:
+*
+*		Width
+*			-Get
+*		Height
+*			-Get
+*		Run
+*			-Get
+*		RunTiles
+*			-Get
+*
+*	Methods:
+*
+*		void Build(TileLayoutView Layout)
+*			Replaces the contents with a sparse copy of Layout.
+*		void Empty()
+*			Removes every tile and makes the layout 0x0.
+*		void GetRowRuns(int Y, int & FirstRun, int & EndRun)
+*			Returns the range of runs in row Y.
+*
+*	Data Members:
+*
+*		TArray<SparseTileRun> m_runs
+*			Every run, in row order and by X within a row.
+*		TArray<TileData> m_tiles
+*			The tiles of every run back to back.
+*		TArray<int> m_rowFirstRun
+*			The index of the first run of each row, plus one past the last run at the end. Row Y's runs
+*			are m_rowFirstRun[Y] up to m_rowFirstRun[Y + 1].
+*		int m_width
+*			The number of tiles in a row.
+*		int m_height
+*			The number of rows.
+**********************************************************************************************************/
+class HALVA_API SparseTileLayout
+{
+public:
+
+	SparseTileLayout();
+	SparseTileLayout(TileLayoutView Layout);
+
+	int GetWidth() const;
+	int GetHeight() const;
+	const SparseTileRun & GetRun(int Index) const;
+	const TileData * GetRunTiles(int Index) const;
+
+	void Build(TileLayoutView Layout);
+	void Empty();
+	void GetRowRuns(int Y, int & FirstRun, int & EndRun) const;
+
+private:
+
+	TArray<SparseTileRun> m_runs;
+	TArray<TileData> m_tiles;
+	TArray<int> m_rowFirstRun;
+	int m_width;
+	int m_height;
+};
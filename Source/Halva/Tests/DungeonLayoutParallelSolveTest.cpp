@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "DungeonLayout.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDungeonLayoutParallelSolveTest, "Halva.DungeonLayout.ParallelTileSolve", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**********************************************************************************************************
+*	bool RunTest(const FString & Parameters)
+*		Purpose:	Checks that solving the tiles in parallel row bands gives exactly the same layout as
+*					solving them serially. Each seed is generated once with bParallelTileSolve off and once
+*					with it on, for each ETileSolveMode, and the two tile buffers must match byte for byte.
+*					The sizes span several solve bands and are not all multiples of the band height, and
+*					some seeds erode so the floors are not only rectangles.
+*
+*		Parameters:
+*			const FString & Parameters
+*				Unused.
+*
+*		Return:		True once every seed has been compared. A mismatch is reported as an error.
+**********************************************************************************************************/
+bool FDungeonLayoutParallelSolveTest::RunTest(const FString & Parameters)
+{
+	static const int SEEDS = 64;
+	static const ETileSolveMode SOLVE_MODES[] = { ETileSolveMode::FullScan, ETileSolveMode::Frontier };
+
+	for (ETileSolveMode solveMode : SOLVE_MODES)
+	{
+		for (int seed = 0; seed < SEEDS; seed++)
+		{
+			int size = 40 + (seed % 8) * 23;
+			FVector dungeonSize = FVector(size, size, 0);
+			int desiredRooms = 4 + seed % 13;
+			int erosionPasses = seed % 3;
+
+			FDungeonGenerationOptions options = FDungeonGenerationOptions();
+			options.TileSolveMode = solveMode;
+
+			options.bParallelTileSolve = false;
+			DungeonLayout serial = DungeonLayout(dungeonSize, FVector(4, 4, 0), desiredRooms, 3, erosionPasses, 0.3f, FRandomStream(seed), options);
+
+			options.bParallelTileSolve = true;
+			DungeonLayout parallel = DungeonLayout(dungeonSize, FVector(4, 4, 0), desiredRooms, 3, erosionPasses, 0.3f, FRandomStream(seed), options);
+
+			TileLayoutView serialTiles = serial.GetDungeonLayout();
+			TileLayoutView parallelTiles = parallel.GetDungeonLayout();
+
+			if (serialTiles.tiles == nullptr || parallelTiles.tiles == nullptr || serialTiles.width != parallelTiles.width || serialTiles.height != parallelTiles.height)
+			{
+				AddError(FString::Printf(TEXT("Seed %d, solve mode %d: layouts were not generated at the same size."), seed, (int)solveMode));
+				continue;
+			}
+
+			if (FMemory::Memcmp(serialTiles.tiles, parallelTiles.tiles, sizeof(TileData) * serialTiles.width * serialTiles.height) != 0)
+				AddError(FString::Printf(TEXT("Seed %d, solve mode %d: parallel tile solve does not match the serial solve."), seed, (int)solveMode));
+		}
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "TileSolver.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTileSolverSolveTableTest, "Halva.TileSolver.SolveTable", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**********************************************************************************************************
+*	bool RunTest(const FString & Parameters)
+*		Purpose:	Checks SOLVE_TABLE against the wall rules for all 256 neighbor masks, then pins the
+*					triple inside corners. The original solver also collected the center tile as a corner,
+*					so a triple inside corner whose open corner is scanned after the center was turned
+*					from the center instead of the open corner. Each of the four triple corners must now be
+*					turned one more quarter than the last as the open corner goes around.
+*
+*		Parameters:
+*			const FString & Parameters
+*				Unused.
+*
+*		Return:		True once every mask has been checked. A mismatch is reported as an error.
+**********************************************************************************************************/
+bool FTileSolverSolveTableTest::RunTest(const FString & Parameters)
+{
+	for (int neighborMask = 0; neighborMask < 256; neighborMask++)
+	{
+		TileData ruleTile = TileData();
+		bool solved = TileSolver::SolveNeighborMaskByRules((uint8)neighborMask, ruleTile);
+
+		TileData tableTile = TileSolver::SolveNeighborMask((uint8)neighborMask);
+
+		if (!solved || ruleTile != tableTile)
+			AddError(FString::Printf(TEXT("Neighbor mask %d: table %d, rules %d."), neighborMask, tableTile.packedTile, solved ? ruleTile.packedTile : -1));
+	}
+
+	// Every diagonal floor except the open one, with the quarter turns the tile must have.
+	static const uint8 TRIPLE_CORNER_MASKS[4] = { 0x85, 0xA4, 0xA1, 0x25 };
+	static const int TRIPLE_CORNER_TURNS[4] = { 0, 1, 2, 3 };
+
+	for (int i = 0; i < 4; i++)
+	{
+		TileData tile = TileSolver::SolveNeighborMask(TRIPLE_CORNER_MASKS[i]);
+
+		if (tile.GetTileType() != TileType::insideTripleCornerTile || tile.GetQuarterTurns() != TRIPLE_CORNER_TURNS[i])
+			AddError(FString::Printf(TEXT("Triple inside corner mask %d: type %d turned %d, expected %d."), TRIPLE_CORNER_MASKS[i], (int)tile.GetTileType(), tile.GetQuarterTurns(), TRIPLE_CORNER_TURNS[i]));
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,359 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Halva.h"
+#include "TileSolver.h"
+
+/**********************************************************************************************************
+*	SOLVE_TABLE
+*		The packed TileData (type in the low 4 bits, quarter turns in the next 2) for every neighbor
+*		mask. Generated from SolveNeighborMaskByRules and checked against it for all 256 masks by the
+*		Halva.TileSolver.SolveTable automation test.
+*		Rotating a neighborhood by 90 degrees gives the same tile type turned by one quarter, which is a
+*		quick sanity check if this ever needs to be edited by hand.
+**********************************************************************************************************/
+const uint8 TileSolver::SOLVE_TABLE[256] =
+{
+	0x00, 0x36, 0x32, 0x32, 0x06, 0x07, 0x32, 0x32, 0x22, 0x22, 0x35, 0x35, 0x2F, 0x2F, 0x35, 0x35,	// 0x00
+	0x02, 0x0E, 0x05, 0x05, 0x02, 0x0E, 0x05, 0x05, 0x23, 0x23, 0x34, 0x34, 0x23, 0x23, 0x34, 0x34,	// 0x10
+	0x26, 0x37, 0x3E, 0x3E, 0x08, 0x39, 0x3E, 0x3E, 0x22, 0x22, 0x35, 0x35, 0x2F, 0x2F, 0x35, 0x35,	// 0x20
+	0x0F, 0x0D, 0x0C, 0x0C, 0x0F, 0x0D, 0x0C, 0x0C, 0x23, 0x23, 0x34, 0x34, 0x23, 0x23, 0x34, 0x34,	// 0x30
+	0x12, 0x1F, 0x33, 0x33, 0x1E, 0x1D, 0x33, 0x33, 0x25, 0x25, 0x24, 0x24, 0x2C, 0x2C, 0x24, 0x24,	// 0x40
+	0x15, 0x1C, 0x04, 0x04, 0x15, 0x1C, 0x04, 0x04, 0x14, 0x14, 0x0B, 0x0B, 0x14, 0x14, 0x0B, 0x0B,	// 0x50
+	0x12, 0x1F, 0x33, 0x33, 0x1E, 0x1D, 0x33, 0x33, 0x25, 0x25, 0x24, 0x24, 0x2C, 0x2C, 0x24, 0x24,	// 0x60
+	0x15, 0x1C, 0x04, 0x04, 0x15, 0x1C, 0x04, 0x04, 0x14, 0x14, 0x0B, 0x0B, 0x14, 0x14, 0x0B, 0x0B,	// 0x70
+	0x16, 0x38, 0x3F, 0x3F, 0x17, 0x09, 0x3F, 0x3F, 0x2E, 0x2E, 0x3C, 0x3C, 0x2D, 0x2D, 0x3C, 0x3C,	// 0x80
+	0x02, 0x0E, 0x05, 0x05, 0x02, 0x0E, 0x05, 0x05, 0x23, 0x23, 0x34, 0x34, 0x23, 0x23, 0x34, 0x34,	// 0x90
+	0x27, 0x29, 0x3D, 0x3D, 0x19, 0x0A, 0x3D, 0x3D, 0x2E, 0x2E, 0x3C, 0x3C, 0x2D, 0x2D, 0x3C, 0x3C,	// 0xA0
+	0x0F, 0x0D, 0x0C, 0x0C, 0x0F, 0x0D, 0x0C, 0x0C, 0x23, 0x23, 0x34, 0x34, 0x23, 0x23, 0x34, 0x34,	// 0xB0
+	0x12, 0x1F, 0x33, 0x33, 0x1E, 0x1D, 0x33, 0x33, 0x25, 0x25, 0x24, 0x24, 0x2C, 0x2C, 0x24, 0x24,	// 0xC0
+	0x15, 0x1C, 0x04, 0x04, 0x15, 0x1C, 0x04, 0x04, 0x14, 0x14, 0x0B, 0x0B, 0x14, 0x14, 0x0B, 0x0B,	// 0xD0
+	0x12, 0x1F, 0x33, 0x33, 0x1E, 0x1D, 0x33, 0x33, 0x25, 0x25, 0x24, 0x24, 0x2C, 0x2C, 0x24, 0x24,	// 0xE0
+	0x15, 0x1C, 0x04, 0x04, 0x15, 0x1C, 0x04, 0x04, 0x14, 0x14, 0x0B, 0x0B, 0x14, 0x14, 0x0B, 0x0B	// 0xF0
+};
+/**********************************************************************************************************
+*	static uint8 GetNeighborMask(TileLayoutView Layout, int X, int Y)
+*		Purpose:	Packs which of the 8 neighbors of (X, Y) are floors into a mask.
+*
+*		Parameters:
+*			TileLayoutView Layout
+*				The layout to read.
+*			int X, int Y
+*				The tile to find the neighbors of.
+*
+*		Return:		The neighbor mask. Neighbors outside the layout are not floors.
+**********************************************************************************************************/
+uint8 TileSolver::GetNeighborMask(TileLayoutView Layout, int X, int Y)
+{
+	uint8 neighborMask = 0;
+	int bit = 0;
+
+	for (int yOffset = -1; yOffset <= 1; yOffset++)
+	{
+		for (int xOffset = -1; xOffset <= 1; xOffset++)
+		{
+			if (xOffset == 0 && yOffset == 0)
+				continue;
+
+			if (Layout.IsValidTile(X + xOffset, Y + yOffset) &&
+				Layout(X + xOffset, Y + yOffset).GetTileType() == TileType::floorTile)
+				neighborMask |= 1 << bit;
+
+			bit++;
+		}
+	}
+
+	return neighborMask;
+}
+/**********************************************************************************************************
+*	static uint8 GetNeighborMask(const FloorBitboard & Floors, int X, int Y)
+*		Purpose:	Packs which of the 8 neighbors of (X, Y) are floors into a mask.
+*
+*		Parameters:
+*			const FloorBitboard & Floors
+*				The floors of the layout.
+*			int X, int Y
+*				The tile to find the neighbors of.
+*
+*		Return:		The neighbor mask. Neighbors outside the board are not floors.
+**********************************************************************************************************/
+uint8 TileSolver::GetNeighborMask(const FloorBitboard & Floors, int X, int Y)
+{
+	uint8 neighborMask = 0;
+
+	neighborMask |= Floors.IsFloor(X - 1, Y - 1) << 0;
+	neighborMask |= Floors.IsFloor(X, Y - 1) << 1;
+	neighborMask |= Floors.IsFloor(X + 1, Y - 1) << 2;
+	neighborMask |= Floors.IsFloor(X - 1, Y) << 3;
+	neighborMask |= Floors.IsFloor(X + 1, Y) << 4;
+	neighborMask |= Floors.IsFloor(X - 1, Y + 1) << 5;
+	neighborMask |= Floors.IsFloor(X, Y + 1) << 6;
+	neighborMask |= Floors.IsFloor(X + 1, Y + 1) << 7;
+
+	return neighborMask;
+}
+/**********************************************************************************************************
+*	static TileData SolveNeighborMask(uint8 NeighborMask)
+*		Purpose:	Finds the tile that completes the dungeon wall for a neighborhood.
+*
+*		Parameters:
+*			uint8 NeighborMask
+*				Which neighbors of the tile are floors. See GetNeighborMask.
+*
+*		Return:		The solved tile.
+**********************************************************************************************************/
+TileData TileSolver::SolveNeighborMask(uint8 NeighborMask)
+{
+	TileData solvedTile;
+	solvedTile.packedTile = SOLVE_TABLE[NeighborMask];
+
+	return solvedTile;
+}
+/**********************************************************************************************************
+*	static bool SolveNeighborMaskByRules(uint8 NeighborMask, TileData & TileOut)
+*		Purpose:	Solves a neighborhood from the wall rules directly. This is the original tile solver
+*					with the layout reads replaced by the mask. It is kept as the reference SOLVE_TABLE
+*					is checked against by the Halva.TileSolver.SolveTable automation test and should not
+*					be used while generating. The original solver also
+*					collected the center tile as a corner, which turned a triple inside corner 225 degrees
+*					whenever its open corner was scanned after the center. The center is skipped here.
+*
+*		Parameters:
+*			uint8 NeighborMask
+*				Which neighbors of the tile are floors. See GetNeighborMask.
+*			TileData & TileOut
+*				The tile solved.
+*
+*		Return:		Returns the tile could be solved for.
+**********************************************************************************************************/
+bool TileSolver::SolveNeighborMaskByRules(uint8 NeighborMask, TileData & TileOut)
+{
+	TArray<FVector2D> adjFloors = TArray<FVector2D>();
+	TArray<FVector2D> adjOthers = TArray<FVector2D>();
+
+	TArray<FVector2D> cornerFloors = TArray<FVector2D>();
+	TArray<FVector2D> cornerOthers = TArray<FVector2D>();
+
+	// DATA COLLECTION
+
+	// NOTE: For standard rotation the y axis will be backwards.
+	int bit = 0;
+
+	for (int yOffset = -1; yOffset <= 1; yOffset++)
+	{
+		for (int xOffset = -1; xOffset <= 1; xOffset++)
+		{
+			if (xOffset == 0 && yOffset == 0)
+				continue;
+
+			bool isFloor = ((NeighborMask >> bit) & 1) != 0;
+			bit++;
+
+			// XOR - get tiles adjacent to the center.
+			if ((xOffset != 0) != (yOffset != 0))
+			{
+				if (isFloor)
+					adjFloors.Add(FVector2D(xOffset, -yOffset));
+				else
+					adjOthers.Add(FVector2D(xOffset, -yOffset));
+			}
+			else
+			{
+				if (isFloor)
+					cornerFloors.Add(FVector2D(xOffset, -yOffset));
+				else
+					cornerOthers.Add(FVector2D(xOffset, -yOffset));
+			}
+		}
+	}
+
+	// DECISION MAKING
+
+	// Empty.
+	if (adjFloors.Num() == 0 && cornerFloors.Num() == 0)
+	{
+		TileOut.SetTileType(TileType::emptyTile);
+		TileOut.SetQuarterTurns(0);
+		return true;
+	}
+
+	// Pillar or floor.
+	else if (adjFloors.Num() == 4)
+	{
+		TileOut.SetTileType(TileType::pillarTile);
+		TileOut.SetQuarterTurns(0);
+		return true;
+	}
+
+	// 1 sided wall or T junction or Wall corner composite
+	else if (adjFloors.Num() == 1)
+	{
+		TileOut.SetTileType(TileType::oneSidedWallTile);
+		float angle = FMath::RadiansToDegrees(FMath::Atan2(adjFloors[0].Y, adjFloors[0].X));
+
+		angle = FMath::RoundToFloat(angle);
+
+		if (angle < 0)
+			angle += 360;
+
+		TileOut.SetYaw(-angle);
+
+		for (int i = 0; i < cornerFloors.Num(); i++)
+		{
+			float cornerFloorAngle = FMath::RadiansToDegrees(FMath::Atan2(cornerFloors[i].Y, cornerFloors[i].X));
+
+			cornerFloorAngle = FMath::RoundToFloat(cornerFloorAngle);
+
+			if (cornerFloorAngle < 0)
+				cornerFloorAngle += 360;
+
+			if (cornerFloorAngle == FMath::Fmod(angle + 135, 360))
+			{
+				if (TileOut.GetTileType() == TileType::oneSidedWallTile)
+					TileOut.SetTileType(TileType::wallCornerCompositeTile);
+				else
+					TileOut.SetTileType(TileType::tJuctionTile);
+			}
+			else if (cornerFloorAngle == FMath::Fmod(angle + 225, 360))
+			{
+				if (TileOut.GetTileType() == TileType::oneSidedWallTile)
+					TileOut.SetTileType(TileType::wallCornerCompositeReversedTile);
+				else
+					TileOut.SetTileType(TileType::tJuctionTile);
+			}
+		}
+
+		return true;
+	}
+
+	// 3 sided wall.
+	else if (adjFloors.Num() == 3)
+	{
+		TileOut.SetTileType(TileType::threeSidedWallTile);
+
+		// Set the angle to the floor tile across from the other tile.
+		float angle = FMath::Atan2(-adjOthers[0].Y, -adjOthers[0].X);
+
+		TileOut.SetYaw(-FMath::RadiansToDegrees(angle));
+
+		return true;
+	}
+
+	// Outside corner or 2 sided wall or L bend.
+	else if (adjFloors.Num() == 2)
+	{
+		// 2 sided wall.
+		if (adjFloors[0].X + adjFloors[1].X == 0)
+		{
+			TileOut.SetTileType(TileType::twoSidedWallTile);
+
+			float angle = FMath::Atan2(adjFloors[0].Y, adjFloors[0].X);
+
+			TileOut.SetYaw(-FMath::RadiansToDegrees(angle));
+
+			return true;
+		}
+		// Outside corner or L Bend.
+		else
+		{
+			TileOut.SetTileType(TileType::outsideCornerTile);
+
+			for (int i = 0; i < cornerFloors.Num(); i++)
+			{
+				// if there is a corner floor opposite the two legs
+				if (cornerFloors[i].X == -(adjFloors[0].X + adjFloors[1].X) &&
+					cornerFloors[i].Y == -(adjFloors[0].Y + adjFloors[1].Y))
+				{
+					// This is an L bend.
+					TileOut.SetTileType(TileType::lBendTile);
+					break;
+				}
+			}
+
+			float angle0 = FMath::Atan2(adjFloors[0].Y, adjFloors[0].X);
+			if (angle0 < 0)
+				angle0 += 2.0F * PI;
+
+			float angle1 = FMath::Atan2(adjFloors[1].Y, adjFloors[1].X);
+			if (angle1 < 0)
+				angle1 += 2.0F * PI;
+
+			// Find the clockwise-most leg of the right triangle the two angles form.
+			if (angle1 == FMath::Fmod(angle0 + (PI / 2.0F), 2.0F * PI))
+				TileOut.SetYaw(-FMath::RadiansToDegrees(angle0));
+			else
+				TileOut.SetYaw(-FMath::RadiansToDegrees(angle1));
+
+			return true;
+		}
+	}
+
+	// Inside corner.
+	else if (adjFloors.Num() == 0 && cornerFloors.Num() > 0)
+	{
+		// The number of diagonal floors corresponds to the type of tile.
+		switch (cornerFloors.Num())
+		{
+		//Single corner
+		case 1:
+		{
+			TileOut.SetTileType(TileType::insideSingleCornerTile);
+			// subtract pi/4 for the clockwise-most leg.
+			float angle = FMath::Atan2(cornerFloors[0].Y, cornerFloors[0].X) - PI / 4;
+			TileOut.SetYaw(-FMath::RadiansToDegrees(angle));
+			break;
+		}
+		// Double corner
+		case 2:
+		{
+			// Opposite inside double corner.
+			if (cornerFloors[0].X + cornerFloors[1].X == 0 && cornerFloors[0].Y + cornerFloors[1].Y == 0)
+			{
+				TileOut.SetTileType(TileType::insideDoubleOppositeCornerTile);
+				float angle = FMath::Atan2(cornerFloors[0].Y, cornerFloors[0].X) - PI / 4;
+				TileOut.SetYaw(-FMath::RadiansToDegrees(angle));
+			}
+			// Adjacent inside double corner.
+			else
+			{
+				TileOut.SetTileType(TileType::insideDoubleAdjacentCornerTile);
+
+				float angle0 = FMath::Atan2(cornerFloors[0].Y, cornerFloors[0].X);
+				if (angle0 < 0)
+					angle0 += 2.0F * PI;
+				float angle1 = FMath::Atan2(cornerFloors[1].Y, cornerFloors[1].X);
+				if (angle1 < 0)
+					angle1 += 2.0F * PI;
+
+				// Find the clockwise-most leg of the right triangle the two angles form.
+				if (angle1 == FMath::Fmod(angle0 + (PI / 2.0F), 2.0F * PI))
+					TileOut.SetYaw(-FMath::RadiansToDegrees(angle0 - PI / 4));
+				else
+					TileOut.SetYaw(-FMath::RadiansToDegrees(angle1 - PI / 4));
+			}
+			break;
+		}
+		// Triple corner.
+		case 3:
+		{
+			TileOut.SetTileType(TileType::insideTripleCornerTile);
+			// subtract pi/4 for the clockwise-most leg.
+			float angle = FMath::Atan2(-cornerOthers[0].Y, -cornerOthers[0].X) - PI / 4;
+			TileOut.SetYaw(-FMath::RadiansToDegrees(angle));
+			break;
+		}
+		// Quadra corner.
+		case 4:
+		{
+			TileOut.SetTileType(TileType::insideQuadraCornerTile);
+			TileOut.SetQuarterTurns(0);
+			break;
+		}
+		default:
+			return false;
+		}
+
+		return true;
+	}
+
+	return false;
+}
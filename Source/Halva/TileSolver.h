@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "TileStructure.h"
+#include "FloorBitboard.h"
+/**********************************************************************************************************
+*	Class: TileSolver
+*
+*	Overview:
+*		Picks the tile type and rotation that completes the dungeon wall at a location. The only thing
+*		that decides the tile is which of its 8 neighbors are floors, so the neighborhood is packed into
+*		an 8 bit mask and the answer is read out of a 256 entry table. No memory is allocated and no
+*		trigonometry is done when solving.
+*
+*		Bit N of a neighbor mask is set when the neighbor at the Nth (X, Y) offset is a floor, in the
+*		order the neighborhood is scanned: (-1,-1) (0,-1) (1,-1) (-1,0) (1,0) (-1,1) (0,1) (1,1).
+*		Neighbors outside the layout are never floors.
+*
+*	Methods:
+*
+*		static uint8 GetNeighborMask(TileLayoutView Layout, int X, int Y)
+*			Builds the neighbor mask of the tile at (X, Y) by reading the layout.
+*		static uint8 GetNeighborMask(const FloorBitboard & Floors, int X, int Y)
+*			Builds the neighbor mask of the tile at (X, Y) by reading a floor bitboard.
+*		static TileData SolveNeighborMask(uint8 NeighborMask)
+*			Returns the tile that solves the given neighborhood.
+*		static bool SolveNeighborMaskByRules(uint8 NeighborMask, TileData & TileOut)
+*			The rules the table was built from. Slow, only used by the Halva.TileSolver.SolveTable
+*			automation test to check the table.
+*
+*	Data Members:
+*
+*		static const uint8 SOLVE_TABLE[256]
+*			The packed TileData that solves each neighbor mask.
+**********************************************************************************************************/
+class HALVA_API TileSolver
+{
+public:
+
+	static uint8 GetNeighborMask(TileLayoutView Layout, int X, int Y);
+	static uint8 GetNeighborMask(const FloorBitboard & Floors, int X, int Y);
+	static TileData SolveNeighborMask(uint8 NeighborMask);
+	static bool SolveNeighborMaskByRules(uint8 NeighborMask, TileData & TileOut);
+
+private:
+
+	static const uint8 SOLVE_TABLE[256];
+};
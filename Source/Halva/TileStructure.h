@@ -31,11 +31,218 @@ enum TileType
 *	struct TileData
 *
 *		Purpose:
-*			Contains useful data for placing and orienting tiles.
+*			Contains useful data for placing and orienting tiles. Tiles only ever turn in steps of 90
+*			degrees about the Z axis, so the whole tile is packed into a single byte: the low 4 bits
+*			hold the TileType and the next 2 bits hold the number of quarter turns of yaw. The rotator
+*			is rebuilt on demand and the location of a tile is its index in the layout, see
+*			TileLayoutView::GetTileLocation.
 **********************************************************************************************************/
 struct TileData
 {
-	TileType tileType;
-	FRotator tileRotation;
-	FVector2D tileLocation;
-};
\ No newline at end of file
+	uint8 packedTile;
+
+	TileData()
+		: packedTile(0)
+	{
+	}
+
+	explicit TileData(TileType Type, int QuarterTurns = 0)
+		: packedTile(0)
+	{
+		SetTileType(Type);
+		SetQuarterTurns(QuarterTurns);
+	}
+
+	TileType GetTileType() const
+	{
+		return (TileType)(packedTile & TILE_TYPE_BITS);
+	}
+
+	void SetTileType(TileType Type)
+	{
+		packedTile = (uint8)((packedTile & ~TILE_TYPE_BITS) | (Type & TILE_TYPE_BITS));
+	}
+
+	// The number of 90 degree turns of yaw, 0 through 3.
+	int GetQuarterTurns() const
+	{
+		return (packedTile & TILE_TURN_BITS) >> TILE_TURN_SHIFT;
+	}
+
+	// Any number of turns is accepted and wrapped into 0 through 3. -1 is the same as 3.
+	void SetQuarterTurns(int QuarterTurns)
+	{
+		packedTile = (uint8)((packedTile & ~TILE_TURN_BITS) | ((QuarterTurns & 3) << TILE_TURN_SHIFT));
+	}
+
+	// Stores the yaw given in degrees rounded to the closest quarter turn.
+	void SetYaw(float Yaw)
+	{
+		SetQuarterTurns(FMath::RoundToInt(Yaw / 90.0f));
+	}
+
+	FRotator GetRotation() const
+	{
+		return FRotator(0, GetQuarterTurns() * 90.0f, 0);
+	}
+
+	bool operator==(const TileData & rhs) const
+	{
+		return packedTile == rhs.packedTile;
+	}
+
+	bool operator!=(const TileData & rhs) const
+	{
+		return packedTile != rhs.packedTile;
+	}
+
+	static const uint8 TILE_TYPE_BITS = 0x0F;
+	static const uint8 TILE_TURN_BITS = 0x30;
+	static const uint8 TILE_TURN_SHIFT = 4;
+};
+
+static_assert(TileType_MAX <= TileData::TILE_TYPE_BITS + 1, "TileType no longer fits in the packed tile.");
+static_assert(sizeof(TileData) == 1, "TileData is expected to pack into a single byte.");
+/**********************************************************************************************************
+*	struct TileLayoutView
+*
+*		Purpose:
+*			A non-owning view over a row-major grid of tiles. Tile (X, Y) lives at tiles[Y * width + X]
+*			so a whole row can be walked without chasing a pointer per row. The view does not free the
+*			tiles it points to and is only valid for as long as the owning layout is unchanged.
+**********************************************************************************************************/
+struct TileLayoutView
+{
+	TileData * tiles;
+	int width;
+	int height;
+
+	TileLayoutView()
+		: tiles(nullptr), width(0), height(0)
+	{
+	}
+
+	TileLayoutView(TileData * Tiles, int Width, int Height)
+		: tiles(Tiles), width(Width), height(Height)
+	{
+	}
+
+	// The number of tiles in the view.
+	int Num() const
+	{
+		return width * height;
+	}
+
+	// If (X, Y) falls inside the view.
+	bool IsValidTile(int X, int Y) const
+	{
+		return X >= 0 && Y >= 0 && X < width && Y < height;
+	}
+
+	// Bounds checked access to the tile at (X, Y).
+	TileData & operator()(int X, int Y) const
+	{
+		check(tiles != nullptr && IsValidTile(X, Y));
+		return tiles[Y * width + X];
+	}
+
+	// The location in tiles of the tile at Index. Tiles do not store their location.
+	FVector2D GetTileLocation(int Index) const
+	{
+		check(width > 0);
+		return FVector2D(Index % width, Index / width);
+	}
+
+	// Returns a pointer to the first tile of row Y. The row is width tiles long.
+	TileData * GetRow(int Y) const
+	{
+		check(tiles != nullptr && Y >= 0 && Y < height);
+		return tiles + Y * width;
+	}
+};
+/**********************************************************************************************************
+*	struct TileSpan
+*
+*		Purpose:
+*			A run of tiles in one row of a layout, from xStart up to but not including xEnd.
+**********************************************************************************************************/
+struct TileSpan
+{
+	int y;
+	int xStart;
+	int xEnd;
+
+	TileSpan()
+		: y(0), xStart(0), xEnd(0)
+	{
+	}
+
+	TileSpan(int Y, int XStart, int XEnd)
+		: y(Y), xStart(XStart), xEnd(XEnd)
+	{
+	}
+
+	// The number of tiles in the span.
+	int Num() const
+	{
+		return xEnd - xStart;
+	}
+};
+/**********************************************************************************************************
+*	struct TileRect
+*
+*		Purpose:
+*			A rectangle of tiles in a layout, from (xStart, yStart) up to but not including (xEnd, yEnd).
+**********************************************************************************************************/
+struct TileRect
+{
+	int xStart;
+	int yStart;
+	int xEnd;
+	int yEnd;
+
+	TileRect()
+		: xStart(0), yStart(0), xEnd(0), yEnd(0)
+	{
+	}
+
+	TileRect(int XStart, int YStart, int XEnd, int YEnd)
+		: xStart(XStart), yStart(YStart), xEnd(XEnd), yEnd(YEnd)
+	{
+	}
+
+	// If the rectangle holds no tiles.
+	bool IsEmpty() const
+	{
+		return xStart >= xEnd || yStart >= yEnd;
+	}
+
+	// The part of the rectangle that is also inside Other.
+	TileRect Intersect(const TileRect & Other) const
+	{
+		return TileRect(FMath::Max(xStart, Other.xStart), FMath::Max(yStart, Other.yStart), FMath::Min(xEnd, Other.xEnd), FMath::Min(yEnd, Other.yEnd));
+	}
+};
+/**********************************************************************************************************
+*	struct TileChange
+*
+*		Purpose:
+*			A tile of a layout that was changed, with the tile it was before and the tile it is now.
+**********************************************************************************************************/
+struct TileChange
+{
+	int x;
+	int y;
+	TileData oldTile;
+	TileData newTile;
+
+	TileChange()
+		: x(0), y(0)
+	{
+	}
+
+	TileChange(int X, int Y, TileData OldTile, TileData NewTile)
+		: x(X), y(Y), oldTile(OldTile), newTile(NewTile)
+	{
+	}
+};